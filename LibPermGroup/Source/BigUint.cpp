@@ -0,0 +1,196 @@
+// BigUint.cpp
+
+#include "BigUint.h"
+#include <numeric>
+#include <ostream>
+
+//------------------------------------------------------------------------------------------
+//                                        BigUint
+//------------------------------------------------------------------------------------------
+
+BigUint::BigUint( void )
+{
+}
+
+BigUint::BigUint( uint64_t value )
+{
+	while( value != 0 )
+	{
+		limbArray.push_back( uint32_t( value ) );
+		value >>= 32;
+	}
+}
+
+bool BigUint::GetUint64( uint64_t& value ) const
+{
+	if( limbArray.size() > 2 )
+		return false;
+
+	value = 0;
+	for( uint i = ( uint )limbArray.size(); i > 0; i-- )
+		value = ( value << 32 ) | limbArray[ i - 1 ];
+
+	return true;
+}
+
+void BigUint::MultiplyBy( uint factor )
+{
+	if( factor == 0 )
+	{
+		limbArray.clear();
+		return;
+	}
+
+	uint64_t carry = 0;
+	for( uint i = 0; i < limbArray.size(); i++ )
+	{
+		uint64_t product = uint64_t( limbArray[i] ) * factor + carry;
+		limbArray[i] = uint32_t( product );
+		carry = product >> 32;
+	}
+
+	if( carry != 0 )
+		limbArray.push_back( uint32_t( carry ) );
+}
+
+// This is long multiplication.  The product may be either of the factors.
+void BigUint::Multiply( const BigUint& numberA, const BigUint& numberB )
+{
+	std::vector< uint32_t > productArray( numberA.limbArray.size() + numberB.limbArray.size(), 0 );
+
+	for( uint i = 0; i < numberA.limbArray.size(); i++ )
+	{
+		uint64_t carry = 0;
+		for( uint j = 0; j < numberB.limbArray.size(); j++ )
+		{
+			uint64_t product = uint64_t( numberA.limbArray[i] ) * numberB.limbArray[j] + productArray[ i + j ] + carry;
+			productArray[ i + j ] = uint32_t( product );
+			carry = product >> 32;
+		}
+
+		productArray[ i + numberB.limbArray.size() ] = uint32_t( carry );
+	}
+
+	limbArray.swap( productArray );
+	Trim();
+}
+
+uint BigUint::DivideBy( uint divisor )
+{
+	if( divisor == 0 )
+		return 0;
+
+	uint64_t remainder = 0;
+	for( uint i = ( uint )limbArray.size(); i > 0; i-- )
+	{
+		uint64_t dividend = ( remainder << 32 ) | limbArray[ i - 1 ];
+		limbArray[ i - 1 ] = uint32_t( dividend / divisor );
+		remainder = dividend % divisor;
+	}
+
+	Trim();
+	return uint( remainder );
+}
+
+uint BigUint::Modulo( uint divisor ) const
+{
+	if( divisor == 0 )
+		return 0;
+
+	uint64_t remainder = 0;
+	for( uint i = ( uint )limbArray.size(); i > 0; i-- )
+		remainder = ( ( remainder << 32 ) | limbArray[ i - 1 ] ) % divisor;
+
+	return uint( remainder );
+}
+
+// The LCM of n and x is n times x over their GCD, and the GCD of n and x is the GCD of x and
+// n mod x, so only a remainder by a small number is ever needed.
+void BigUint::LcmWith( uint x )
+{
+	if( IsZero() )
+		return;
+
+	if( x == 0 )
+	{
+		limbArray.clear();
+		return;
+	}
+
+	MultiplyBy( x / std::gcd( Modulo(x), x ) );
+}
+
+int BigUint::Compare( const BigUint& number ) const
+{
+	if( limbArray.size() != number.limbArray.size() )
+		return ( limbArray.size() < number.limbArray.size() ) ? -1 : 1;
+
+	for( uint i = ( uint )limbArray.size(); i > 0; i-- )
+		if( limbArray[ i - 1 ] != number.limbArray[ i - 1 ] )
+			return ( limbArray[ i - 1 ] < number.limbArray[ i - 1 ] ) ? -1 : 1;
+
+	return 0;
+}
+
+// The digits are found nine at a time, by dividing by a billion.
+std::string BigUint::ToString( void ) const
+{
+	if( IsZero() )
+		return "0";
+
+	BigUint quotient = *this;
+	std::vector< uint > chunkArray;
+	while( !quotient.IsZero() )
+		chunkArray.push_back( quotient.DivideBy( 1000000000 ) );
+
+	std::string string = std::to_string( chunkArray.back() );
+	for( uint i = ( uint )chunkArray.size() - 1; i > 0; i-- )
+	{
+		std::string chunk = std::to_string( chunkArray[ i - 1 ] );
+		string += std::string( 9 - chunk.size(), '0' ) + chunk;
+	}
+
+	return string;
+}
+
+bool BigUint::FromString( const std::string& string )
+{
+	if( string.size() == 0 )
+		return false;
+
+	BigUint number;
+	for( uint i = 0; i < string.size(); i++ )
+	{
+		char digit = string[i];
+		if( digit < '0' || digit > '9' )
+			return false;
+
+		number.MultiplyBy( 10 );
+		uint64_t carry = uint( digit - '0' );
+		for( uint j = 0; j < number.limbArray.size() && carry != 0; j++ )
+		{
+			uint64_t sum = uint64_t( number.limbArray[j] ) + carry;
+			number.limbArray[j] = uint32_t( sum );
+			carry = sum >> 32;
+		}
+
+		if( carry != 0 )
+			number.limbArray.push_back( uint32_t( carry ) );
+	}
+
+	limbArray.swap( number.limbArray );
+	return true;
+}
+
+void BigUint::Print( std::ostream& ostream ) const
+{
+	ostream << ToString();
+}
+
+void BigUint::Trim( void )
+{
+	while( limbArray.size() > 0 && limbArray.back() == 0 )
+		limbArray.pop_back();
+}
+
+// BigUint.cpp
@@ -0,0 +1,63 @@
+// BigUint.h
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+typedef unsigned int uint;
+
+//------------------------------------------------------------------------------------------
+//                                        BigUint
+//------------------------------------------------------------------------------------------
+
+// This is an unsigned integer of any size, for the orders of groups and permutations, which
+// are products and LCMs that can easily get past 64 bits.  Only what those need is here:
+// multiplying, LCMs with small numbers, comparing, and converting to and from decimal.
+// It's held as 32-bit limbs, least significant first, with no leading zero limbs, so zero
+// has none at all.
+class BigUint
+{
+public:
+
+	BigUint( void );
+	BigUint( uint64_t value );
+
+	bool IsZero( void ) const { return limbArray.size() == 0; }
+
+	// This is whether the value fits in 64 bits, and if so, gives it.
+	bool GetUint64( uint64_t& value ) const;
+
+	void MultiplyBy( uint factor );
+	void Multiply( const BigUint& numberA, const BigUint& numberB );
+
+	// These give the remainder.  Dividing by zero gives zero and leaves the number as it is.
+	uint DivideBy( uint divisor );
+	uint Modulo( uint divisor ) const;
+
+	// The number becomes the LCM of itself and the given one.  The LCM with zero is zero.
+	void LcmWith( uint x );
+
+	int Compare( const BigUint& number ) const;
+
+	bool operator==( const BigUint& number ) const { return limbArray == number.limbArray; }
+	bool operator!=( const BigUint& number ) const { return limbArray != number.limbArray; }
+	bool operator<( const BigUint& number ) const { return Compare( number ) < 0; }
+	bool operator<=( const BigUint& number ) const { return Compare( number ) <= 0; }
+	bool operator>( const BigUint& number ) const { return Compare( number ) > 0; }
+	bool operator>=( const BigUint& number ) const { return Compare( number ) >= 0; }
+
+	std::string ToString( void ) const;
+	bool FromString( const std::string& string );
+	void Print( std::ostream& ostream ) const;
+
+	std::vector< uint32_t > limbArray;
+
+private:
+
+	void Trim( void );
+};
+
+// BigUint.h
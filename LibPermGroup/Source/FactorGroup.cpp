@@ -26,9 +26,7 @@ void FactorGroup::Generate( const PermutationSet& generatorSet, std::ostream* os
 	// how to do that, so we're estimating when we might be done.  Yes, it's lame.
 	while( permutationQueue.size() > 0 && consecutiveHitCount < consecutiveHitCountMax )
 	{
-		PermutationSet::iterator iter = permutationQueue.begin();
-		Permutation permutation = *iter;
-		permutationQueue.erase( iter );
+		Permutation permutation = std::move( permutationQueue.extract( permutationQueue.begin() ).value() );
 
 		PermutationSet::iterator foundIter = FindCoset( permutation );
 		if( foundIter != cosetRepresentativeSet.end() )
@@ -49,7 +47,7 @@ void FactorGroup::Generate( const PermutationSet& generatorSet, std::ostream* os
 			if( processedSet.find( newPermutation ) == processedSet.end() &&
 				permutationQueue.find( newPermutation ) == permutationQueue.end() )
 			{
-				permutationQueue.insert( newPermutation );
+				permutationQueue.insert( std::move( newPermutation ) );
 			}
 		}
 	}
@@ -0,0 +1,166 @@
+// FixedPermutation.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <array>
+#include <utility>
+#include <cstring>
+#include <type_traits>
+#include <initializer_list>
+
+//------------------------------------------------------------------------------------------
+//                                    FixedPermutation
+//------------------------------------------------------------------------------------------
+
+// This is a permutation of a degree fixed at compile time, held in a plain array of the
+// narrowest type able to hold its points.  All of it can be done at compile time, so a set
+// of generators can be written as a constexpr table of cycles, and since the degree is
+// known, small permutations are composed and inverted in straight-line code.  Points at or
+// past the degree are fixed.  GetPermutation turns one into an ordinary permutation, which
+// is how these are handed to a stabilizer chain.
+template< uint Degree >
+class FixedPermutation
+{
+public:
+
+	// These are the same widths a point map of this degree would have, so maps are copied
+	// between the two as they are.
+	typedef typename std::conditional< ( Degree <= 0x100 ), uint8_t, typename std::conditional< ( Degree <= 0x10000 ), uint16_t, uint32_t >::type >::type Point;
+
+	typedef std::initializer_list< uint > Cycle;
+
+	constexpr FixedPermutation( void )
+	{
+		DefineIdentity();
+	}
+
+	// Each cycle takes each of its points to the next one, and its last point to its first.
+	// In a constant expression, a point past the degree fails to compile.
+	constexpr FixedPermutation( std::initializer_list< Cycle > cycleList )
+	{
+		DefineIdentity();
+		for( const Cycle* cycle = cycleList.begin(); cycle != cycleList.end(); cycle++ )
+			DefineCycle( *cycle );
+	}
+
+	constexpr void DefineIdentity( void )
+	{
+		for( uint i = 0; i < Degree; i++ )
+			map[i] = Point(i);
+	}
+
+	constexpr void DefineCycle( Cycle cycle )
+	{
+		const uint* pointArray = cycle.begin();
+		uint size = ( uint )cycle.size();
+		for( uint i = 0; i < size; i++ )
+			map[ pointArray[i] ] = Point( pointArray[ ( i + 1 ) % size ] );
+	}
+
+	constexpr uint Evaluate( uint point ) const
+	{
+		return ( point < Degree ) ? map[ point ] : point;
+	}
+
+	constexpr bool IsIdentity( void ) const
+	{
+		return *this == FixedPermutation();
+	}
+
+	constexpr bool operator==( const FixedPermutation& permutation ) const
+	{
+		return map == permutation.map;
+	}
+
+	// As with Permutation::Multiply, the product applies this permutation first.
+	constexpr FixedPermutation operator*( const FixedPermutation& permutation ) const
+	{
+		if constexpr( Degree <= unrollLimit )
+			return Compose( permutation, std::make_index_sequence< Degree >() );
+
+		FixedPermutation product( ( Uninitialized() ) );
+		for( uint i = 0; i < Degree; i++ )
+			product.map[i] = permutation.map[ map[i] ];
+		return product;
+	}
+
+	constexpr FixedPermutation Inverse( void ) const
+	{
+		if constexpr( Degree <= unrollLimit )
+			return Invert( std::make_index_sequence< Degree >() );
+
+		FixedPermutation inverse( ( Uninitialized() ) );
+		for( uint i = 0; i < Degree; i++ )
+			inverse.map[ map[i] ] = Point(i);
+		return inverse;
+	}
+
+	// The permutation is given the same map, and no word.
+	void GetPermutation( Permutation& permutation ) const
+	{
+		PointMap& pointMap = permutation.map;
+		pointMap.Prepare( PointMap::CapacityForDegree( Degree ), 0 );
+		memcpy( pointMap.Data(), map.data(), sizeof( map ) );
+		pointMap.SetSize( Degree );
+		pointMap.Trim();
+
+		permutation.cachedHash = 0;
+		permutation.supportState = Permutation::SupportUnknown;
+		permutation.word.reset();
+		permutation.wordProgram.reset();
+	}
+
+	// This fails if the permutation moves a point past the degree.
+	bool SetPermutation( const Permutation& permutation )
+	{
+		if( permutation.map.Size() > Degree )
+			return false;
+
+		for( uint i = 0; i < Degree; i++ )
+			map[i] = Point( permutation.Evaluate(i) );
+
+		return true;
+	}
+
+	// Permutations no bigger than a point map held inline are unrolled completely.
+	static const uint unrollLimit = PointMap::inlineCapacity;
+
+	std::array< Point, Degree > map;
+
+private:
+
+	struct Uninitialized {};
+
+	constexpr explicit FixedPermutation( Uninitialized ) {}
+
+	template< std::size_t... Index >
+	constexpr FixedPermutation Compose( const FixedPermutation& permutation, std::index_sequence< Index... > ) const
+	{
+		FixedPermutation product( ( Uninitialized() ) );
+		( ( product.map[ Index ] = permutation.map[ map[ Index ] ] ), ... );
+		return product;
+	}
+
+	template< std::size_t... Index >
+	constexpr FixedPermutation Invert( std::index_sequence< Index... > ) const
+	{
+		FixedPermutation inverse( ( Uninitialized() ) );
+		( ( inverse.map[ map[ Index ] ] = Point( Index ) ), ... );
+		return inverse;
+	}
+};
+
+// Every permutation of the table is made into an ordinary one and added to the set.
+template< uint Degree, std::size_t Count >
+void InsertFixedPermutations( const FixedPermutation< Degree > ( &permutationTable )[ Count ], PermutationSet& permutationSet )
+{
+	Permutation permutation;
+	for( std::size_t i = 0; i < Count; i++ )
+	{
+		permutationTable[i].GetPermutation( permutation );
+		permutationSet.insert( permutation );
+	}
+}
+
+// FixedPermutation.h
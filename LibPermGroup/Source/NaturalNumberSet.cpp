@@ -2,6 +2,8 @@
 
 #include "NaturalNumberSet.h"
 #include <ostream>
+#include <algorithm>
+#include <bit>
 
 //------------------------------------------------------------------------------------------
 //                                    NaturalNumberSet
@@ -9,99 +11,223 @@
 
 NaturalNumberSet::NaturalNumberSet( void )
 {
+	dense = false;
+	denseCount = 0;
 }
 
 NaturalNumberSet::NaturalNumberSet( const NaturalNumberSet& set )
 {
+	dense = false;
+	denseCount = 0;
 	Copy( set );
 }
 
-/*virtual*/ NaturalNumberSet::~NaturalNumberSet( void )
+NaturalNumberSet::NaturalNumberSet( NaturalNumberSet&& set ) noexcept
 {
+	dense = false;
+	denseCount = 0;
+	*this = std::move( set );
+}
+
+NaturalNumberSet::~NaturalNumberSet( void )
+{
+}
+
+NaturalNumberSet& NaturalNumberSet::operator=( const NaturalNumberSet& set )
+{
+	if( this != &set )
+		Copy( set );
+	return *this;
+}
+
+// The moved-from set is left empty.
+NaturalNumberSet& NaturalNumberSet::operator=( NaturalNumberSet&& set ) noexcept
+{
+	if( this != &set )
+	{
+		dense = set.dense;
+		denseCount = set.denseCount;
+		memberArray = std::move( set.memberArray );
+		wordArray = std::move( set.wordArray );
+		set.RemoveAllMembers();
+	}
+	return *this;
 }
 
 bool NaturalNumberSet::IsEmpty( void ) const
 {
-	return( set.size() == 0 ? true : false );
+	return( Cardinality() == 0 ? true : false );
 }
 
 bool NaturalNumberSet::IsMember( uint x ) const
 {
-	UintSet::iterator iter = set.find(x);
-	if( iter == set.end() )
-		return false;
-	return true;
+	if( dense )
+		return x / 64 < wordArray.size() && ( ( wordArray[ x / 64 ] >> ( x % 64 ) ) & 1 );
+
+	return std::binary_search( memberArray.cbegin(), memberArray.cend(), x );
 }
 
 void NaturalNumberSet::AddMember( uint x )
 {
-	set.insert(x);
+	if( dense )
+	{
+		if( x / 64 >= wordArray.size() )
+		{
+			// A bitset only grows to take in a far-off member if it's still worth having.
+			if( x / 64 >= 2 * wordArray.size() && !DenseIsWorthwhile( denseCount + 1, x ) )
+			{
+				MakeSparse();
+				AddMember(x);
+				return;
+			}
+
+			wordArray.resize( x / 64 + 1, 0 );
+		}
+
+		uint64_t bit = uint64_t( 1 ) << ( x % 64 );
+		if( !( wordArray[ x / 64 ] & bit ) )
+		{
+			wordArray[ x / 64 ] |= bit;
+			denseCount++;
+		}
+
+		return;
+	}
+
+	std::vector< uint >::iterator iter = std::lower_bound( memberArray.begin(), memberArray.end(), x );
+	if( iter != memberArray.end() && *iter == x )
+		return;
+
+	memberArray.insert( iter, x );
+
+	if( memberArray.size() > maxSparseCount && DenseIsWorthwhile( ( uint )memberArray.size(), memberArray.back() ) )
+		MakeDense( memberArray.back() + 1 );
 }
 
 void NaturalNumberSet::RemoveMember( uint x )
 {
-	set.erase(x);
+	if( dense )
+	{
+		if( IsMember(x) )
+		{
+			wordArray[ x / 64 ] &= ~( uint64_t( 1 ) << ( x % 64 ) );
+			denseCount--;
+		}
+
+		return;
+	}
+
+	std::vector< uint >::iterator iter = std::lower_bound( memberArray.begin(), memberArray.end(), x );
+	if( iter != memberArray.end() && *iter == x )
+		memberArray.erase( iter );
 }
 
 void NaturalNumberSet::RemoveAllMembers( void )
 {
-	set.clear();
+	dense = false;
+	denseCount = 0;
+	memberArray.clear();
+	wordArray.clear();
+}
+
+void NaturalNumberSet::Reserve( uint bound )
+{
+	if( !dense )
+		MakeDense( bound );
+	else if( ( bound + 63 ) / 64 > wordArray.size() )
+		wordArray.resize( ( bound + 63 ) / 64, 0 );
 }
 
 uint NaturalNumberSet::Cardinality( void ) const
 {
-	return ( uint )set.size();
+	return dense ? denseCount : ( uint )memberArray.size();
 }
 
 void NaturalNumberSet::Copy( const NaturalNumberSet& set, bool clear /*= true*/ )
 {
-	if( clear )
-		this->set.clear();
-	for( UintSet::const_iterator iter = set.set.cbegin(); iter != set.set.cend(); iter++ )
-		this->set.insert( *iter );
+	if( !clear )
+	{
+		UnionWith( set );
+		return;
+	}
+
+	if( this == &set )
+		return;
+
+	dense = set.dense;
+	denseCount = set.denseCount;
+	memberArray = set.memberArray;
+	wordArray = set.wordArray;
 }
 
 void NaturalNumberSet::Union( const NaturalNumberSet& setA, const NaturalNumberSet& setB )
 {
-	Copy( setA );
-	Copy( setB, false );
+	if( this == &setB )
+		UnionWith( setA );
+	else
+	{
+		Copy( setA );
+		UnionWith( setB );
+	}
 }
 
+// Two bitsets are intersected a word at a time.  Otherwise, the members of the smaller
+// set are looked up in the other.
 void NaturalNumberSet::Intersect( const NaturalNumberSet& setA, const NaturalNumberSet& setB )
 {
-	set.clear();
+	if( setA.dense && setB.dense )
+	{
+		uint wordCount = ( uint )std::min( setA.wordArray.size(), setB.wordArray.size() );
+		std::vector< uint64_t > newWordArray( wordCount );
+		uint newCount = 0;
+		for( uint i = 0; i < wordCount; i++ )
+		{
+			newWordArray[i] = setA.wordArray[i] & setB.wordArray[i];
+			newCount += std::popcount( newWordArray[i] );
+		}
+
+		memberArray.clear();
+		wordArray.swap( newWordArray );
+		denseCount = newCount;
+		dense = true;
+		return;
+	}
+
+	const NaturalNumberSet* smallSet = &setA;
+	const NaturalNumberSet* otherSet = &setB;
+	if( setB.Cardinality() < setA.Cardinality() )
+		std::swap( smallSet, otherSet );
 
-	for( UintSet::const_iterator iter = setA.set.cbegin(); iter != setA.set.cend(); iter++ )
-		if( setB.IsMember( *iter ) )
-			set.insert( *iter );
+	std::vector< uint > sortedArray;
+	for( const_iterator iter = smallSet->cbegin(); iter != smallSet->cend(); iter++ )
+		if( otherSet->IsMember( *iter ) )
+			sortedArray.push_back( *iter );
+
+	AssignSorted( sortedArray );
 }
 
 void NaturalNumberSet::GenerateDivisorsOf( uint x )
 {
-	set.clear();
+	std::vector< uint > sortedArray;
 
 	for( uint d = 1; d <= x / 2; d++ )
 		if( x % d == 0 )
-			set.insert(d);
+			sortedArray.push_back(d);
+
+	AssignSorted( sortedArray );
 }
 
-uint NaturalNumberSet::CalcLCM( void ) const
+// The LCM of many numbers quickly gets past 32 bits, so it's found exactly.
+BigUint NaturalNumberSet::CalcLCM( void ) const
 {
 	if( Cardinality() == 0 )
-		return 0;
-	else if( Cardinality() == 1 )
-		return *set.begin();
-	else if( Cardinality() == 2 )
-	{
-		UintSet::iterator iter = set.begin();
-		iter++;
-		return Lcm( *set.begin(), *iter );
-	}
+		return BigUint(0);
 
-	NaturalNumberSet reducedSet;
-	reducedSet.Copy( *this );
-	reducedSet.RemoveMember( *set.begin() );
-	return Lcm( reducedSet.CalcLCM(), *set.begin() );
+	BigUint lcm(1);
+	for( const_iterator iter = cbegin(); iter != cend(); iter++ )
+		lcm.LcmWith( *iter );
+
+	return lcm;
 }
 
 uint NaturalNumberSet::CalcGCD( void ) const
@@ -109,23 +235,27 @@ uint NaturalNumberSet::CalcGCD( void ) const
 	if( Cardinality() == 0 )
 		return 0;
 	else if( Cardinality() == 1 )
-		return *set.begin();
+		return Min();
 	else if( Cardinality() == 2 )
 	{
-		UintSet::iterator iter = set.begin();
+		const_iterator iter = cbegin();
 		iter++;
-		return Gcd( *set.begin(), *iter );
+		return Gcd( Min(), *iter );
 	}
 
 	NaturalNumberSet reducedSet;
 	reducedSet.Copy( *this );
-	reducedSet.RemoveMember( *set.begin() );
-	return Lcm( reducedSet.CalcGCD(), *set.begin() );
+	reducedSet.RemoveMember( Min() );
+	return Gcd( reducedSet.CalcGCD(), Min() );
 }
 
 /*static*/ uint NaturalNumberSet::Lcm( uint a, uint b )
 {
-	return( a * b / Gcd( a, b ) );
+	if( a == 0 || b == 0 )
+		return 0;
+
+	// Dividing first keeps the intermediate result no bigger than the LCM itself.
+	return( a / Gcd( a, b ) * b );
 }
 
 /*static*/ uint NaturalNumberSet::Gcd( uint a, uint b )
@@ -138,25 +268,43 @@ uint NaturalNumberSet::CalcGCD( void ) const
 
 uint NaturalNumberSet::Max( void ) const
 {
-	uint maxMember = 0;
-	for( UintSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
-		if( *iter > maxMember )
-			maxMember = *iter;
-	return maxMember;
+	if( !dense )
+		return memberArray.size() > 0 ? memberArray.back() : 0;
+
+	for( uint i = ( uint )wordArray.size(); i > 0; i-- )
+		if( wordArray[ i - 1 ] )
+			return ( i - 1 ) * 64 + 63 - std::countl_zero( wordArray[ i - 1 ] );
+
+	return 0;
 }
 
 uint NaturalNumberSet::Min( void ) const
 {
-	uint minMember = -1;
-	for( UintSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
-		if( *iter < minMember )
-			minMember = *iter;
-	return minMember;
+	if( !dense )
+		return memberArray.size() > 0 ? memberArray.front() : -1;
+
+	return NextDenseMember(0);
 }
 
+// Between two bitsets, no member of this one can be missing from any word of the other.
 bool NaturalNumberSet::IsSubsetOf( const NaturalNumberSet& givenSet ) const
 {
-	for( UintSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
+	if( Cardinality() > givenSet.Cardinality() )
+		return false;
+
+	if( dense && givenSet.dense )
+	{
+		for( uint i = 0; i < wordArray.size(); i++ )
+		{
+			uint64_t givenWord = ( i < givenSet.wordArray.size() ) ? givenSet.wordArray[i] : 0;
+			if( wordArray[i] & ~givenWord )
+				return false;
+		}
+
+		return true;
+	}
+
+	for( const_iterator iter = cbegin(); iter != cend(); iter++ )
 		if( !givenSet.IsMember( *iter ) )
 			return false;
 	return true;
@@ -167,16 +315,121 @@ bool NaturalNumberSet::IsSupsetOf( const NaturalNumberSet& givenSet ) const
 	return givenSet.IsSubsetOf( *this );
 }
 
+NaturalNumberSet::const_iterator NaturalNumberSet::cbegin( void ) const
+{
+	if( dense )
+		return const_iterator( this, NextDenseMember(0) );
+
+	return const_iterator( this, memberArray.size() > 0 ? 0 : endPosition );
+}
+
+uint NaturalNumberSet::NextPosition( uint position ) const
+{
+	if( dense )
+		return NextDenseMember( position + 1 );
+
+	return ( position + 1 < memberArray.size() ) ? position + 1 : endPosition;
+}
+
+// This is the first member of the bitset from the given point onward, found a word at a time.
+uint NaturalNumberSet::NextDenseMember( uint x ) const
+{
+	uint i = x / 64;
+	if( i >= wordArray.size() )
+		return endPosition;
+
+	uint64_t word = wordArray[i] & ( ~uint64_t(0) << ( x % 64 ) );
+	while( word == 0 )
+	{
+		if( ++i == wordArray.size() )
+			return endPosition;
+
+		word = wordArray[i];
+	}
+
+	return i * 64 + std::countr_zero( word );
+}
+
+void NaturalNumberSet::MakeDense( uint bound )
+{
+	std::vector< uint64_t > newWordArray( ( bound + 63 ) / 64, 0 );
+	for( uint i = 0; i < memberArray.size(); i++ )
+	{
+		uint x = memberArray[i];
+		if( x / 64 >= newWordArray.size() )
+			newWordArray.resize( x / 64 + 1, 0 );
+		newWordArray[ x / 64 ] |= uint64_t( 1 ) << ( x % 64 );
+	}
+
+	denseCount = ( uint )memberArray.size();
+	wordArray.swap( newWordArray );
+	memberArray.clear();
+	dense = true;
+}
+
+void NaturalNumberSet::MakeSparse( void )
+{
+	std::vector< uint > sortedArray;
+	sortedArray.reserve( denseCount );
+	for( const_iterator iter = cbegin(); iter != cend(); iter++ )
+		sortedArray.push_back( *iter );
+
+	wordArray.clear();
+	denseCount = 0;
+	dense = false;
+	memberArray.swap( sortedArray );
+}
+
+void NaturalNumberSet::UnionWith( const NaturalNumberSet& set )
+{
+	if( this == &set )
+		return;
+
+	if( dense && set.dense )
+	{
+		if( set.wordArray.size() > wordArray.size() )
+			wordArray.resize( set.wordArray.size(), 0 );
+
+		denseCount = 0;
+		for( uint i = 0; i < wordArray.size(); i++ )
+		{
+			if( i < set.wordArray.size() )
+				wordArray[i] |= set.wordArray[i];
+			denseCount += std::popcount( wordArray[i] );
+		}
+
+		return;
+	}
+
+	for( const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
+		AddMember( *iter );
+}
+
+// The given members, in increasing order, replace those of the set.
+void NaturalNumberSet::AssignSorted( std::vector< uint >& sortedArray )
+{
+	RemoveAllMembers();
+	memberArray.swap( sortedArray );
+
+	if( memberArray.size() > maxSparseCount && DenseIsWorthwhile( ( uint )memberArray.size(), memberArray.back() ) )
+		MakeDense( memberArray.back() + 1 );
+}
+
+/*static*/ bool NaturalNumberSet::DenseIsWorthwhile( uint count, uint maxMember )
+{
+	return maxMember / 64 < uint64_t( count ) * maxWordsPerMember;
+}
+
 void NaturalNumberSet::Print( std::ostream& ostream ) const
 {
 	ostream << "{";
-	UintSet::const_iterator iter = set.cbegin();
-	while( iter != set.cend() )
+	const_iterator iter = cbegin();
+	while( iter != cend() )
 	{
 		ostream << *iter;
-		UintSet::const_iterator nextIter = iter;
+		const_iterator nextIter = iter;
 		nextIter++;
-		if( nextIter != set.cend() )
+		if( nextIter != cend() )
 			ostream << ",";
 		iter = nextIter;
 	}
@@ -185,7 +438,7 @@ void NaturalNumberSet::Print( std::ostream& ostream ) const
 
 void NaturalNumberSet::GetToJsonValue( rapidjson::Value& setValue, rapidjson::Document::AllocatorType& allocator ) const
 {
-	for( UintSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
+	for( const_iterator iter = cbegin(); iter != cend(); iter++ )
 		setValue.PushBack( *iter, allocator );
 }
 
@@ -2,10 +2,11 @@
 
 #pragma once
 
-#include <set>
 #include <iostream>
 #include <vector>
+#include <cstdint>
 #include "rapidjson/document.h"
+#include "BigUint.h"
 
 typedef unsigned int uint;
 
@@ -17,13 +18,23 @@ typedef std::vector< NaturalNumberSet > NaturalNumberSetArray;
 //                                    NaturalNumberSet
 //------------------------------------------------------------------------------------------
 
+// A set starts out as a sorted array of its members, which suits the one or two base points
+// of a stabilizer, however large they are.  Once it has more than a few members, and they're
+// packed closely enough that a bitset would spend no more than a few words on each of them,
+// it becomes a bitset, and stays one.  Membership is then a single bit test, and unions,
+// intersections and subset tests between bitsets go a word at a time.  Either way, members
+// are iterated in increasing order.
 class NaturalNumberSet
 {
 public:
 
 	NaturalNumberSet( void );
 	NaturalNumberSet( const NaturalNumberSet& set );
-	virtual ~NaturalNumberSet( void );
+	NaturalNumberSet( NaturalNumberSet&& set ) noexcept;
+	~NaturalNumberSet( void );
+
+	NaturalNumberSet& operator=( const NaturalNumberSet& set );
+	NaturalNumberSet& operator=( NaturalNumberSet&& set ) noexcept;
 
 	bool IsEmpty( void ) const;
 	bool IsMember( uint x ) const;
@@ -32,6 +43,10 @@ public:
 	void RemoveAllMembers( void );
 	void Print( std::ostream& ostream ) const;
 
+	// The set is made a bitset big enough for every member below the given bound, so that
+	// adding and looking up members such as the points of an orbit takes constant time.
+	void Reserve( uint bound );
+
 	void GetToJsonValue( rapidjson::Value& setValue, rapidjson::Document::AllocatorType& allocator ) const;
 	void SetFromJsonValue( /*const*/ rapidjson::Value& setValue );
 
@@ -46,7 +61,7 @@ public:
 
 	void GenerateDivisorsOf( uint x );
 
-	uint CalcLCM( void ) const;
+	BigUint CalcLCM( void ) const;
 	uint CalcGCD( void ) const;
 
 	uint Max( void ) const;
@@ -55,8 +70,64 @@ public:
 	static uint Lcm( uint a, uint b );
 	static uint Gcd( uint a, uint b );
 
-	typedef std::set< uint > UintSet;
-	UintSet set;
+	// The position is an index into the member array, or a member of the bitset.
+	class const_iterator
+	{
+	public:
+
+		const_iterator( void ) : set( nullptr ), position( endPosition ) {}
+		const_iterator( const NaturalNumberSet* set, uint position ) : set( set ), position( position ) {}
+
+		uint operator*( void ) const { return set->dense ? position : set->memberArray[ position ]; }
+
+		const_iterator& operator++( void )
+		{
+			position = set->NextPosition( position );
+			return *this;
+		}
+
+		const_iterator operator++( int )
+		{
+			const_iterator iter = *this;
+			position = set->NextPosition( position );
+			return iter;
+		}
+
+		bool operator==( const const_iterator& iter ) const { return position == iter.position; }
+		bool operator!=( const const_iterator& iter ) const { return position != iter.position; }
+
+		const NaturalNumberSet* set;
+		uint position;
+	};
+
+	const_iterator cbegin( void ) const;
+	const_iterator cend( void ) const { return const_iterator( this, endPosition ); }
+	const_iterator begin( void ) const { return cbegin(); }
+	const_iterator end( void ) const { return cend(); }
+
+	static const uint endPosition = 0xFFFFFFFF;
+
+	// A sorted array is kept until it has more than this many members.
+	static const uint maxSparseCount = 16;
+
+	// A bitset is worth having when it takes no more than this many words per member.
+	static const uint maxWordsPerMember = 4;
+
+private:
+
+	uint NextPosition( uint position ) const;
+	uint NextDenseMember( uint x ) const;
+	void MakeDense( uint bound );
+	void MakeSparse( void );
+	void UnionWith( const NaturalNumberSet& set );
+	void AssignSorted( std::vector< uint >& sortedArray );
+
+	static bool DenseIsWorthwhile( uint count, uint maxMember );
+
+	bool dense;
+	uint denseCount;
+	std::vector< uint > memberArray;
+	std::vector< uint64_t > wordArray;
 };
 
 // NaturalNumberSet.h
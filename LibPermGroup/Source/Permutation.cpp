@@ -2,16 +2,65 @@
 
 #include "Permutation.h"
 #include "NaturalNumberSet.h"
+#include "PointMapKernels.h"
+#include "ScratchArena.h"
+#include "PermutationCodec.h"
 #include <sstream>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
 #include "rapidjson/writer.h"
 
+//------------------------------------------------------------------------------------------
+//                                    GeneratorAlphabet
+//------------------------------------------------------------------------------------------
+
+// A deque never moves its elements, so a name can be read after the lock is released.
+static std::mutex alphabetMutex;
+static std::deque< std::string > alphabetNameArray;
+static std::unordered_map< std::string, uint > alphabetIdMap;
+
+/*static*/ uint GeneratorAlphabet::Intern( const std::string& name )
+{
+	std::lock_guard< std::mutex > lock( alphabetMutex );
+
+	std::unordered_map< std::string, uint >::iterator iter = alphabetIdMap.find( name );
+	if( iter != alphabetIdMap.end() )
+		return iter->second;
+
+	uint id = ( uint )alphabetNameArray.size();
+	alphabetNameArray.push_back( name );
+	alphabetIdMap.insert( std::pair< std::string, uint >( name, id ) );
+	return id;
+}
+
+/*static*/ const std::string& GeneratorAlphabet::Name( uint id )
+{
+	std::lock_guard< std::mutex > lock( alphabetMutex );
+	return alphabetNameArray[ id ];
+}
+
+/*static*/ uint GeneratorAlphabet::Size( void )
+{
+	std::lock_guard< std::mutex > lock( alphabetMutex );
+	return ( uint )alphabetNameArray.size();
+}
+
 //------------------------------------------------------------------------------------------
 //                                        Permutation
 //------------------------------------------------------------------------------------------
 
+/*static*/ std::atomic< uint64_t > Permutation::copyCount( 0 );
+/*static*/ std::atomic< uint64_t > Permutation::moveCount( 0 );
+
 Permutation::Permutation( void )
 {
-	DefineIdentity();
+	cachedHash = 0;
+	supportState = SupportUnknown;
 }
 
 Permutation::Permutation( const Permutation& permutation )
@@ -19,21 +68,38 @@ Permutation::Permutation( const Permutation& permutation )
 	SetCopy( permutation );
 }
 
-/*virtual*/ Permutation::~Permutation( void )
+Permutation::Permutation( Permutation&& permutation ) noexcept
+{
+	cachedHash = 0;
+	supportState = SupportUnknown;
+	*this = std::move( permutation );
+}
+
+Permutation::~Permutation( void )
 {
 }
 
 uint Permutation::Evaluate( uint input ) const
 {
 	uint output = input;
-	if( input < (uint)map.size() )
+	if( input < map.Capacity() )
 		output = map[ input ];
 	return output;
 }
 
 bool Permutation::Stabilizes( const NaturalNumberSet& set ) const
 {
-	for( NaturalNumberSet::UintSet::const_iterator iter = set.set.cbegin(); iter != set.set.cend(); iter++ )
+	// A sparse permutation stabilizes the set if none of its moved points are in it.
+	if( supportState == SupportSparse && supportArray.size() < set.Cardinality() )
+	{
+		for( uint i = 0; i < supportArray.size(); i++ )
+			if( set.IsMember( supportArray[i] ) )
+				return false;
+
+		return true;
+	}
+
+	for( NaturalNumberSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
 	{
 		uint inputPoint = *iter;
 		uint outputPoint = Evaluate( inputPoint );
@@ -46,17 +112,46 @@ bool Permutation::Stabilizes( const NaturalNumberSet& set ) const
 
 void Permutation::DefineIdentity( void )
 {
-	map.clear();
+	// Only the moved points of a sparse map need to be put back.
+	if( supportState == SupportSparse )
+	{
+		for( uint i = 0; i < supportArray.size(); i++ )
+			map.Set( supportArray[i], supportArray[i] );
+		map.SetSize(0);
+	}
+
+	map.Clear();
+	cachedHash = 0;
+	supportState = SupportSparse;
+	supportArray.clear();
 }
 
 void Permutation::Define( uint input, uint output )
 {
-	uint largest = std::max(input, output);
-	if ((uint)map.size() < largest + 1)
-		for (uint i = (uint)map.size(); i < largest + 1; i++)
-			map.push_back(i);
+	cachedHash = 0;
+	supportState = SupportUnknown;
+
+	// Neither point plus one can be allowed to wrap around to zero.
+	if( std::max( input, output ) >= PointMap::maxDegree )
+		throw std::length_error( "Permutation point exceeds the maximum degree." );
+
+	// Points past the size of the map are already fixed, so the map only needs
+	// to grow far enough to hold the input, provided the output fits in its storage.
+	if( input >= map.Size() )
+	{
+		if( input == output )
+			return;
+
+		map.Reserve( std::max(input, output) + 1 );
+		map.Resize( input + 1 );
+	}
+	else
+		map.Reserve( output + 1 );
 
-	map[ input ] = output;
+	map.Set( input, output );
+
+	if( input == output )
+		map.Trim();
 }
 
 void Permutation::DefineCycle( uint a, uint b )
@@ -107,50 +202,343 @@ void Permutation::DefineCycleArray( const uint* cycleArray, uint cycleArraySize
 
 std::size_t Permutation::CalcHash( void ) const
 {
-	std::stringstream stream;
+	if( cachedHash == 0 )
+	{
+		cachedHash = ( std::size_t )PointMapKernels::Hash( map );
+		if( cachedHash == 0 )
+			cachedHash = 1;
+	}
 
-	for( uint i = 0; i < (uint)map.size(); i++ )
-		if( map[i] != i )
-			stream << i << map[i];
+	return cachedHash;
+}
 
-	std::string str = stream.str();
-	std::size_t hash = std::hash< std::string >{}( str );
+//------------------------------------------------------------------------------------------
+//                                    Sparse arithmetic
+//------------------------------------------------------------------------------------------
 
-	return hash;
-}
+// Products between sparse permutations are worked out here, one entry per point they move.
+static thread_local std::vector< uint > scratchPointArray;
+static thread_local std::vector< uint > scratchImageArray;
+static thread_local std::vector< uint > scratchPreimageArray;
+static thread_local std::vector< uint64_t > scratchPairArray;
 
-bool Permutation::IsValid( void ) const
+static bool SupportIsSparse( uint supportSize, uint size )
 {
-	NaturalNumberSet set;
+	if( size == 0 )
+		return true;
 
-	for( uint i = 0; i < (uint)map.size(); i++ )
+	return size > PointMap::inlineCapacity && supportSize * Permutation::sparseRatio <= size;
+}
+
+bool Permutation::IsSparse( void ) const
+{
+	if( supportState == SupportUnknown )
 	{
-		uint j = map[i];
-		if( j >= (uint)map.size() )
+		supportArray.clear();
+		supportState = SupportDense;
+
+		// The scan gives up as soon as too many moved points have been found.
+		uint size = map.Size();
+		if( !SupportIsSparse( 0, size ) )
 			return false;
-		if( set.IsMember(j) )
+
+		uint maxSupportSize = size / sparseRatio;
+		for( uint i = 0; i < size; i++ )
+		{
+			if( map[i] != i )
+			{
+				if( supportArray.size() == maxSupportSize )
+				{
+					supportArray.clear();
+					return false;
+				}
+
+				supportArray.push_back(i);
+			}
+		}
+
+		supportState = SupportSparse;
+	}
+
+	return supportState == SupportSparse;
+}
+
+// The map becomes the identity, other than at the given points, which must be in increasing
+// order and be permuted among themselves by the given images.  If the map was sparse, only
+// its old moved points need to be put back first.
+void Permutation::DefineSparse( const std::vector< uint >& pointArray, const std::vector< uint >& imageArray )
+{
+	if( supportState == SupportSparse )
+	{
+		for( uint i = 0; i < supportArray.size(); i++ )
+			map.Set( supportArray[i], supportArray[i] );
+		map.SetSize(0);
+	}
+	else
+		map.Prepare( map.Capacity(), 0 );
+
+	supportArray.clear();
+	for( uint i = 0; i < pointArray.size(); i++ )
+		if( pointArray[i] != imageArray[i] )
+			supportArray.push_back( pointArray[i] );
+
+	if( supportArray.size() > 0 )
+	{
+		uint size = supportArray.back() + 1;
+		map.Reserve( size );
+		map.SetSize( size );
+
+		for( uint i = 0; i < pointArray.size(); i++ )
+			if( pointArray[i] != imageArray[i] )
+				map.Set( pointArray[i], imageArray[i] );
+	}
+
+	map.Trim();
+	cachedHash = 0;
+	supportState = SupportIsSparse( ( uint )supportArray.size(), map.Size() ) ? SupportSparse : SupportDense;
+}
+
+// The points moved by either of two sparse permutations are merged here in increasing order.
+// The images are worked out in full before the product is written, as it may be a factor.
+static void MergeSupports( const Permutation& permutationA, const Permutation& permutationB )
+{
+	const std::vector< uint >& supportArrayA = permutationA.supportArray;
+	const std::vector< uint >& supportArrayB = permutationB.supportArray;
+
+	scratchPointArray.resize( supportArrayA.size() + supportArrayB.size() );
+	std::vector< uint >::iterator end = std::set_union( supportArrayA.cbegin(), supportArrayA.cend(), supportArrayB.cbegin(), supportArrayB.cend(), scratchPointArray.begin() );
+	scratchPointArray.resize( end - scratchPointArray.begin() );
+}
+
+static void MultiplySparse( Permutation& product, const Permutation& permutationA, const Permutation& permutationB )
+{
+	MergeSupports( permutationA, permutationB );
+
+	scratchImageArray.resize( scratchPointArray.size() );
+	for( uint i = 0; i < scratchPointArray.size(); i++ )
+		scratchImageArray[i] = permutationB.Evaluate( permutationA.Evaluate( scratchPointArray[i] ) );
+
+	product.DefineSparse( scratchPointArray, scratchImageArray );
+}
+
+// Entry i is made the preimage of the i-th moved point.  This fails if the moved points
+// aren't permuted among themselves, in which case the map isn't a bijection.
+static bool MakeSparsePreimages( const Permutation& permutation )
+{
+	const std::vector< uint >& supportArray = permutation.supportArray;
+	scratchPreimageArray.resize( supportArray.size() );
+
+	for( uint i = 0; i < supportArray.size(); i++ )
+	{
+		uint image = permutation.map[ supportArray[i] ];
+		std::vector< uint >::const_iterator iter = std::lower_bound( supportArray.cbegin(), supportArray.cend(), image );
+		if( iter == supportArray.cend() || *iter != image )
 			return false;
-		set.AddMember(j);
+
+		scratchPreimageArray[ iter - supportArray.cbegin() ] = supportArray[i];
 	}
 
 	return true;
 }
 
-bool Permutation::IsEven( void ) const
+static uint SparsePreimage( const Permutation& permutation, uint point )
+{
+	const std::vector< uint >& supportArray = permutation.supportArray;
+	std::vector< uint >::const_iterator iter = std::lower_bound( supportArray.cbegin(), supportArray.cend(), point );
+	if( iter == supportArray.cend() || *iter != point )
+		return point;
+
+	return scratchPreimageArray[ iter - supportArray.cbegin() ];
+}
+
+//------------------------------------------------------------------------------------------
+//                                      Cycle walking
+//------------------------------------------------------------------------------------------
+
+// Points already reached while walking the cycles of a map are marked here.  Being
+// per-thread and reused, it rarely needs to allocate.
+static thread_local std::vector< uint64_t > visitedBitmap;
+
+// A power written over its own base reads a copy of the base from here.
+static thread_local PointMap scratchMap;
+
+// This calls the visitor with the first point and length of every cycle of the map that isn't
+// a fixed point, in a single pass with no allocation.  It fails if the map is not a bijection
+// of the points below its size.
+template< typename PointType, typename CycleVisitor >
+static bool WalkCycles( const PointType* points, uint size, CycleVisitor& visitor )
 {
-	PermutationList permutationList;
-	Factor( permutationList );
+	visitedBitmap.assign( ( size + 63 ) / 64, 0 );
+	uint64_t* visited = visitedBitmap.data();
 
-	uint total = 0;
-	for( PermutationList::iterator iter = permutationList.begin(); iter != permutationList.end(); iter++ )
+	for( uint i = 0; i < size; i++ )
 	{
-		// An N-cycle can be written as N-1 transpositions.
-		const Permutation& permutation = *iter;
-		uint cycleOrder = permutation.CycleOrder();
-		total += cycleOrder - 1;
+		if( ( visited[ i / 64 ] >> ( i % 64 ) ) & 1 )
+			continue;
+
+		uint length = 0;
+		uint j = i;
+
+		do
+		{
+			if( j >= size )
+				return false;
+
+			uint64_t bit = uint64_t( 1 ) << ( j % 64 );
+			if( visited[ j / 64 ] & bit )
+				return false;
+
+			visited[ j / 64 ] |= bit;
+			j = points[j];
+			length++;
+		}
+		while( j != i );
+
+		if( length > 1 )
+			visitor.Cycle( points, i, length );
 	}
 
-	return( total % 2 == 0 ? true : false );
+	return true;
+}
+
+template< typename CycleVisitor >
+static bool WalkCycles( const PointMap& map, CycleVisitor& visitor )
+{
+	switch( map.Width() )
+	{
+		case 1: return WalkCycles( map.Data(), map.Size(), visitor );
+		case 2: return WalkCycles( ( const uint16_t* )map.Data(), map.Size(), visitor );
+	}
+
+	return WalkCycles( ( const uint32_t* )map.Data(), map.Size(), visitor );
+}
+
+struct ValidityVisitor
+{
+	template< typename PointType >
+	void Cycle( const PointType*, uint, uint )
+	{
+	}
+};
+
+// The order is accumulated one cycle at a time as an LCM, checking for overflow as it goes.
+struct CycleStructureVisitor
+{
+	template< typename PointType >
+	void Cycle( const PointType*, uint, uint length )
+	{
+		if( countCycles )
+		{
+			if( length >= cycleStructure->cycleCountArray.size() )
+				cycleStructure->cycleCountArray.resize( length + 1, 0 );
+			cycleStructure->cycleCountArray[ length ]++;
+		}
+
+		cycleStructure->movedCount += length;
+		cycleStructure->cycleCount++;
+
+		if( cycleStructure->orderOverflow )
+		{
+			cycleStructure->largeOrder.LcmWith( length );
+			return;
+		}
+
+		uint64_t& order = cycleStructure->order;
+		if( order == 0 )
+			order = length;
+		else
+		{
+			uint64_t factor = length / std::gcd( order, uint64_t( length ) );
+			if( order > std::numeric_limits< uint64_t >::max() / factor )
+			{
+				cycleStructure->orderOverflow = true;
+				cycleStructure->largeOrder = BigUint( order );
+				cycleStructure->largeOrder.LcmWith( length );
+			}
+			else
+				order *= factor;
+		}
+	}
+
+	CycleStructure* cycleStructure;
+	bool countCycles;
+};
+
+// Raising a cycle of length L to the k-th power moves each of its points k mod L places
+// along it, so every point of the power is found in at most two steps around the cycle.
+struct PowerVisitor
+{
+	template< typename PointType >
+	void Cycle( const PointType* points, uint first, uint length )
+	{
+		structureVisitor.Cycle( points, first, length );
+
+		int64_t shift = int64_t( exponent ) % int64_t( length );
+		if( shift < 0 )
+			shift += length;
+
+		uint x = first;
+		uint y = first;
+		for( int64_t i = 0; i < shift; i++ )
+			y = points[y];
+
+		for( uint i = 0; i < length; i++ )
+		{
+			power->Set( x, y );
+			x = points[x];
+			y = points[y];
+		}
+	}
+
+	CycleStructureVisitor structureVisitor;
+	PointMap* power;
+	int exponent;
+};
+
+static void AppendWord( ElementArray& elementArray, const ElementArray& factorWord, bool inverse )
+{
+	if( !inverse )
+		elementArray.insert( elementArray.end(), factorWord.cbegin(), factorWord.cend() );
+	else
+	{
+		for( ElementArray::const_reverse_iterator iter = factorWord.crbegin(); iter != factorWord.crend(); iter++ )
+		{
+			Element invElement;
+			invElement.id = iter->id;
+			invElement.exponent = -iter->exponent;
+			elementArray.push_back( invElement );
+		}
+	}
+}
+
+bool Permutation::IsValid( void ) const
+{
+	ValidityVisitor visitor;
+	return WalkCycles( map, visitor );
+}
+
+bool Permutation::GetCycleStructure( CycleStructure& cycleStructure, bool countCycles /*= true*/ ) const
+{
+	cycleStructure.cycleCountArray.clear();
+	cycleStructure.order = 0;
+	cycleStructure.orderOverflow = false;
+	cycleStructure.movedCount = 0;
+	cycleStructure.cycleCount = 0;
+
+	CycleStructureVisitor visitor;
+	visitor.cycleStructure = &cycleStructure;
+	visitor.countCycles = countCycles;
+	return WalkCycles( map, visitor );
+}
+
+bool Permutation::IsEven( void ) const
+{
+	// An N-cycle can be written as N-1 transpositions.
+	CycleStructure cycleStructure;
+	if( !GetCycleStructure( cycleStructure, false ) )
+		return true;
+
+	return cycleStructure.IsEven();
 }
 
 bool Permutation::IsOdd( void ) const
@@ -158,21 +546,19 @@ bool Permutation::IsOdd( void ) const
 	return !IsEven();
 }
 
+int Permutation::Sign( void ) const
+{
+	return IsEven() ? 1 : -1;
+}
+
 bool Permutation::IsIdentity( void ) const
 {
-	for( uint i = 0; i < (uint)map.size(); i++ )
-		if( map[i] != i )
-			return false;
-	return true;
+	return map.Size() == 0;
 }
 
 bool Permutation::IsEqualTo( const Permutation& permutation ) const
 {
-	uint largest = (uint)std::max(map.size(), permutation.map.size());
-	for( uint i = 0; i < largest; i++ )
-		if( Evaluate(i) != permutation.Evaluate(i) )
-			return false;
-	return true;
+	return PointMapKernels::IsEqual( map, permutation.map );
 }
 
 bool Permutation::CommutesWith( const Permutation& permutation ) const
@@ -187,29 +573,163 @@ bool Permutation::CommutesWith( const Permutation& permutation ) const
 
 uint Permutation::CycleOrder( void ) const
 {
+	if( supportState == SupportSparse )
+		return ( uint )supportArray.size();
+
 	uint cycleOrder = 0;
-	for( uint i = 0; i < (uint)map.size(); i++ )
+	for( uint i = 0; i < map.Size(); i++ )
 		if( map[i] != i )
 			cycleOrder++;
 	return cycleOrder;
 }
 
+// The identity has order zero here.  So does any permutation whose order doesn't fit in a
+// uint, so that nothing will try to reduce exponents by it.
 uint Permutation::Order( void ) const
 {
-	PermutationList permutationList;
-	Factor( permutationList );
+	CycleStructure cycleStructure;
+	if( !GetCycleStructure( cycleStructure, false ) )
+		return 0;
+
+	if( cycleStructure.orderOverflow || cycleStructure.order > std::numeric_limits< uint >::max() )
+		return 0;
 
-	NaturalNumberSet set;
+	return uint( cycleStructure.order );
+}
+
+// Unlike Order, this is the true order, however large, so the identity's is one.
+bool Permutation::GetOrder( BigUint& order ) const
+{
+	CycleStructure cycleStructure;
+	if( !GetCycleStructure( cycleStructure, false ) )
+		return false;
+
+	order = cycleStructure.ExactOrder();
+	return true;
+}
+
+// The word for a power is built by repeated squaring, so it takes a number of program nodes
+// that grows only with the number of bits in the exponent.  The powers of the base commute,
+// so it doesn't matter in which order the squares are multiplied.
+static WordProgramPtr MakePowerProgram( const WordProgramPtr& baseProgram, bool inverse, uint count )
+{
+	WordProgram::FactorArray factorArray;
 
-	for( PermutationList::iterator iter = permutationList.begin(); iter != permutationList.end(); iter++ )
+	WordProgram::Factor square;
+	square.program = baseProgram;
+	square.inverse = inverse;
+
+	while( count > 0 )
+	{
+		if( count & 1 )
+			factorArray.push_back( square );
+
+		count >>= 1;
+		if( count > 0 )
+		{
+			WordProgram::FactorArray squareFactorArray( 2, square );
+			square.program = WordProgram::MakeProduct( squareFactorArray );
+			square.inverse = false;
+		}
+	}
+
+	return WordProgram::MakeProduct( factorArray );
+}
+
+// The power is made from the cycles of the given permutation, rather than by repeated
+// multiplication, so it costs the same for any exponent.  Its word is the given word raised
+// to the exponent of least magnitude that gives the same permutation.
+void Permutation::Power( const Permutation& permutation, int exponent )
+{
+	bool worded = permutation.HasWord();
+	WordProgramPtr baseProgram = permutation.wordProgram;
+	ElementArray baseWord;
+	if( permutation.word )
+		baseWord = *permutation.word;
+
+	const PointMap* baseMap = &permutation.map;
+	if( baseMap == &map )
+	{
+		scratchMap = map;
+		baseMap = &scratchMap;
+	}
+
+	CycleStructure cycleStructure;
+	cycleStructure.order = 0;
+	cycleStructure.orderOverflow = false;
+	cycleStructure.movedCount = 0;
+	cycleStructure.cycleCount = 0;
+
+	PowerVisitor visitor;
+	visitor.structureVisitor.cycleStructure = &cycleStructure;
+	visitor.structureVisitor.countCycles = false;
+	visitor.power = &map;
+	visitor.exponent = exponent;
+
+	map.Prepare( baseMap->Capacity(), 0 );
+	WalkCycles( *baseMap, visitor );
+	map.SetSize( baseMap->Size() );
+	map.Trim();
+	cachedHash = 0;
+	supportState = SupportUnknown;
+
+	word.reset();
+	wordProgram.reset();
+
+	if( !worded )
+		return;
+
+	// The exponent is replaced by the one of least magnitude that gives the same power.  An
+	// order too large for 64 bits is far larger than any exponent, which is then already reduced.
+	int64_t reducedExponent = exponent;
+	if( cycleStructure.order == 0 )
+		reducedExponent = 0;
+	else if( !cycleStructure.orderOverflow )
 	{
-		const Permutation& permutation = *iter;
-		set.AddMember( permutation.CycleOrder() );
+		uint64_t order = cycleStructure.order;
+		uint64_t residue = uint64_t( reducedExponent < 0 ? -reducedExponent : reducedExponent ) % order;
+		if( reducedExponent < 0 && residue != 0 )
+			residue = order - residue;
+
+		reducedExponent = ( residue > order / 2 ) ? -int64_t( order - residue ) : int64_t( residue );
 	}
 
-	uint order = set.CalcLCM();
+	bool inverse = ( reducedExponent < 0 );
+	uint count = uint( inverse ? -reducedExponent : reducedExponent );
 
-	return order;
+	if( baseProgram )
+	{
+		wordProgram = MakePowerProgram( baseProgram, inverse, count );
+		return;
+	}
+
+	// A single element just has its exponent multiplied, as long as that fits.
+	if( baseWord.size() == 1 )
+	{
+		int64_t elementExponent = int64_t( baseWord[0].exponent ) * reducedExponent;
+		if( elementExponent >= -std::numeric_limits< int >::max() && elementExponent <= std::numeric_limits< int >::max() )
+		{
+			word = std::make_unique<ElementArray>();
+			if( elementExponent != 0 )
+			{
+				Element element = baseWord[0];
+				element.exponent = int( elementExponent );
+				word->push_back( element );
+			}
+			return;
+		}
+	}
+
+	if( count <= 1 || baseWord.size() == 0 )
+	{
+		word = std::make_unique<ElementArray>();
+		if( count == 1 )
+			AppendWord( *word, baseWord, inverse );
+		return;
+	}
+
+	// Anything longer is held as a program, rather than repeating the word.
+	wordProgram = MakePowerProgram( WordProgram::MakeLeaf( baseWord ), inverse, count );
 }
 
 void Permutation::SetCopy( const Permutation& permutation, bool copyWord /*= true*/ )
@@ -219,14 +739,23 @@ void Permutation::SetCopy( const Permutation& permutation, bool copyWord /*= tru
 
 void Permutation::GetCopy( Permutation& permutation, bool copyWord /*= true*/ ) const
 {
+	copyCount.fetch_add( 1, std::memory_order_relaxed );
+
 	permutation.map = map;
+	permutation.cachedHash = cachedHash;
+	permutation.supportState = supportState;
+	if( supportState == SupportSparse )
+		permutation.supportArray = supportArray;
 	permutation.word.reset();
+	permutation.wordProgram.reset();
 
-	if( word && copyWord )
+	if( copyWord )
 	{
-		permutation.word = std::make_unique<ElementList>();
-		for( ElementList::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
-			permutation.word->push_back( *iter );
+		if( word )
+			permutation.word = std::make_unique<ElementArray>( *word );
+
+		// Program nodes are never changed, so the copy just shares them.
+		permutation.wordProgram = wordProgram;
 	}
 }
 
@@ -237,66 +766,290 @@ bool Permutation::SetInverse( const Permutation& permutation )
 
 bool Permutation::GetInverse( Permutation& permutation ) const
 {
-	permutation.DefineIdentity();
+	if( IsSparse() )
+	{
+		if( !MakeSparsePreimages( *this ) )
+			return false;
 
-	for (uint i = 0; i < (uint)map.size(); i++)
+		// The support is copied out first, as the inverse may be written over it.
+		scratchPointArray = supportArray;
+		permutation.DefineSparse( scratchPointArray, scratchPreimageArray );
+	}
+	else
 	{
-		uint j = map[i];
-		if( j >= (uint)map.size() )
+		permutation.cachedHash = 0;
+		permutation.supportState = SupportUnknown;
+		if( !PointMapKernels::Invert( map, permutation.map ) )
 			return false;
+	}
 
-		permutation.Define(j, i);
+	MultiplyWords( permutation, { { this, true } } );
+	return true;
+}
+
+// The product of two permutations is the permutation that applies the first, then the second.
+// The permutation being written may be either of them, and in every one of these products its
+// storage is reused, so that no allocation takes place once it has been sized for the degree.
+// Between sparse permutations, only the points moved by either of them are visited.
+void Permutation::Multiply( const Permutation& permutationA, const Permutation& permutationB )
+{
+	if( permutationA.IsSparse() && permutationB.IsSparse() )
+		MultiplySparse( *this, permutationA, permutationB );
+	else
+	{
+		PointMapKernels::Compose( permutationA.map, permutationB.map, map );
+		cachedHash = 0;
+		supportState = SupportUnknown;
 	}
 
-	if( word )
+	MultiplyWords( *this, { { &permutationA, false }, { &permutationB, false } } );
+}
+
+// This is the product of the first permutation and the inverse of the second, without
+// the inverse ever being materialized as a permutation.
+bool Permutation::MultiplyInverse( const Permutation& permutationA, const Permutation& permutationB )
+{
+	if( permutationA.IsSparse() && permutationB.IsSparse() )
 	{
-		permutation.word = std::make_unique<ElementList>();
+		if( !MakeSparsePreimages( permutationB ) )
+			return false;
 
-		for( ElementList::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
+		MergeSupports( permutationA, permutationB );
+		scratchImageArray.resize( scratchPointArray.size() );
+		for( uint i = 0; i < scratchPointArray.size(); i++ )
+			scratchImageArray[i] = SparsePreimage( permutationB, permutationA.Evaluate( scratchPointArray[i] ) );
+
+		DefineSparse( scratchPointArray, scratchImageArray );
+	}
+	else
+	{
+		cachedHash = 0;
+		supportState = SupportUnknown;
+		if( !PointMapKernels::ComposeInverse( permutationA.map, permutationB.map, map ) )
+			return false;
+	}
+
+	MultiplyWords( *this, { { &permutationA, false }, { &permutationB, true } } );
+	return true;
+}
+
+// This is the inverse of the conjugator, followed by the given permutation, followed by the conjugator.
+// It moves just the images under the conjugator of the points the given permutation moves,
+// so if that one is sparse, the conjugator is only looked up at those points, however dense.
+void Permutation::Conjugate( const Permutation& permutation, const Permutation& conjugator )
+{
+	if( permutation.IsSparse() )
+	{
+		const std::vector< uint >& factorSupportArray = permutation.supportArray;
+		scratchPairArray.resize( factorSupportArray.size() );
+		for( uint i = 0; i < factorSupportArray.size(); i++ )
 		{
-			const Element& element = *iter;
-			Element invElement;
-			invElement.name = element.name;
-			invElement.exponent = -element.exponent;
-			permutation.word->push_front( invElement );
+			uint point = factorSupportArray[i];
+			scratchPairArray[i] = ( uint64_t( conjugator.Evaluate( point ) ) << 32 ) | conjugator.Evaluate( permutation.map[ point ] );
+		}
+
+		std::sort( scratchPairArray.begin(), scratchPairArray.end() );
+
+		scratchPointArray.resize( scratchPairArray.size() );
+		scratchImageArray.resize( scratchPairArray.size() );
+		for( uint i = 0; i < scratchPairArray.size(); i++ )
+		{
+			scratchPointArray[i] = uint( scratchPairArray[i] >> 32 );
+			scratchImageArray[i] = uint( scratchPairArray[i] );
 		}
+
+		DefineSparse( scratchPointArray, scratchImageArray );
+	}
+	else
+	{
+		PointMapKernels::Conjugate( permutation.map, conjugator.map, map );
+		cachedHash = 0;
+		supportState = SupportUnknown;
 	}
 
-	return true;
+	MultiplyWords( *this, { { &conjugator, true }, { &permutation, false }, { &conjugator, false } } );
 }
 
-void Permutation::Multiply( const Permutation& permutationA, const Permutation& permutationB )
+void Permutation::MultiplyOnRight( const Permutation& permutation )
 {
-	DefineIdentity();
+	if( IsSparse() && permutation.IsSparse() )
+		MultiplySparse( *this, *this, permutation );
+	else
+	{
+		PointMapKernels::Compose( map, permutation.map, map );
+		cachedHash = 0;
+		supportState = SupportUnknown;
+	}
 
-	uint largest = (uint)std::max(permutationA.map.size(), permutationB.map.size());
-	for (uint i = 0; i < largest; i++)
-		Define(i, permutationB.Evaluate(permutationA.Evaluate(i)));
+	if( word && permutation.word && &permutation != this )
+		word->insert( word->end(), permutation.word->cbegin(), permutation.word->cend() );
+	else
+		MultiplyWords( *this, { { this, false }, { &permutation, false } } );
+}
 
-	if( permutationA.word.get() && permutationB.word.get())
+// Multiplying on the left only changes the images of the points the left factor moves, so
+// a sparse factor is applied in place, even to a dense permutation.
+void Permutation::MultiplyOnLeft( const Permutation& permutation )
+{
+	if( IsSparse() && permutation.IsSparse() )
+		MultiplySparse( *this, permutation, *this );
+	else if( permutation.IsSparse() )
 	{
-		word = std::make_unique<ElementList>();
+		const std::vector< uint >& factorSupportArray = permutation.supportArray;
+		if( factorSupportArray.size() > 0 )
+		{
+			scratchImageArray.resize( factorSupportArray.size() );
+			for( uint i = 0; i < factorSupportArray.size(); i++ )
+				scratchImageArray[i] = Evaluate( permutation.map[ factorSupportArray[i] ] );
+
+			uint size = factorSupportArray.back() + 1;
+			if( map.Size() < size )
+				map.Resize( size );
 
-		for( ElementList::const_iterator iter = permutationA.word->cbegin(); iter != permutationA.word->cend(); iter++ )
-			word->push_back( *iter );
+			for( uint i = 0; i < factorSupportArray.size(); i++ )
+				map.Set( factorSupportArray[i], scratchImageArray[i] );
 
-		for( ElementList::const_iterator iter = permutationB.word->cbegin(); iter != permutationB.word->cend(); iter++ )
-			word->push_back( *iter );
+			map.Trim();
+			cachedHash = 0;
+			supportState = SupportUnknown;
+		}
 	}
+	else
+	{
+		PointMapKernels::Compose( permutation.map, map, map );
+		cachedHash = 0;
+		supportState = SupportUnknown;
+	}
+
+	if( word && permutation.word && &permutation != this )
+		word->insert( word->begin(), permutation.word->cbegin(), permutation.word->cend() );
+	else
+		MultiplyWords( *this, { { &permutation, false }, { this, false } } );
 }
 
-void Permutation::MultiplyOnRight( const Permutation& permutation )
+// A product only gets a word if all of its factors have one, and it gets a program if any
+// of theirs is one.  Otherwise the product's own array is reused.  If the product is also
+// its own first factor, the rest of the word is simply appended to it.
+/*static*/ void Permutation::MultiplyWords( Permutation& product, std::initializer_list< WordFactor > factorList )
 {
-	Permutation product;
-	product.Multiply( *this, permutation );
-	SetCopy( product );
+	MultiplyWords( product, factorList.begin(), ( uint )factorList.size() );
 }
 
-void Permutation::MultiplyOnLeft( const Permutation& permutation )
+/*static*/ void Permutation::MultiplyWords( Permutation& product, const WordFactor* factorArray, uint factorCount )
+{
+	const WordFactor* factorEnd = factorArray + factorCount;
+	bool program = false;
+
+	for( const WordFactor* factor = factorArray; factor != factorEnd; factor++ )
+	{
+		if( !factor->permutation->HasWord() )
+		{
+			product.word.reset();
+			product.wordProgram.reset();
+			return;
+		}
+
+		if( factor->permutation->wordProgram )
+			program = true;
+	}
+
+	if( program )
+	{
+		WordProgram::FactorArray programFactorArray;
+		programFactorArray.reserve( factorCount );
+
+		for( const WordFactor* factor = factorArray; factor != factorEnd; factor++ )
+		{
+			WordProgram::Factor programFactor;
+			programFactor.program = factor->permutation->wordProgram;
+			if( !programFactor.program )
+				programFactor.program = WordProgram::MakeLeaf( *factor->permutation->word );
+			programFactor.inverse = factor->inverse;
+			programFactorArray.push_back( programFactor );
+		}
+
+		product.word.reset();
+		product.wordProgram = WordProgram::MakeProduct( programFactorArray );
+		return;
+	}
+
+	product.wordProgram.reset();
+
+	const WordFactor* firstFactor = factorArray;
+	bool extending = ( factorCount > 0 && firstFactor->permutation == &product && !firstFactor->inverse );
+	for( const WordFactor* factor = firstFactor + 1; factor < factorEnd; factor++ )
+		if( factor->permutation == &product )
+			extending = false;
+
+	std::unique_ptr<ElementArray> productWord;
+
+	if( extending )
+		firstFactor++;
+	else
+	{
+		for( const WordFactor* factor = factorArray; factor != factorEnd; factor++ )
+		{
+			if( factor->permutation == &product )
+			{
+				productWord = std::move( product.word );
+				break;
+			}
+		}
+
+		if( product.word )
+			product.word->clear();
+		else
+			product.word = std::make_unique<ElementArray>();
+	}
+
+	for( const WordFactor* factor = firstFactor; factor != factorEnd; factor++ )
+	{
+		const ElementArray& factorWord = ( factor->permutation == &product ) ? *productWord : *factor->permutation->word;
+		AppendWord( *product.word, factorWord, factor->inverse );
+	}
+}
+
+uint Permutation::WordLength( void ) const
+{
+	if( wordProgram )
+		return uint( std::min( wordProgram->length, uint64_t( std::numeric_limits< uint >::max() ) ) );
+
+	if( word )
+		return ( uint )word->size();
+
+	return 0;
+}
+
+// A permutation with no word gets the empty word.
+void Permutation::MakeWordProgram( void )
 {
-	Permutation product;
-	product.Multiply( permutation, *this );
-	SetCopy( product );
+	if( wordProgram )
+		return;
+
+	wordProgram = WordProgram::MakeLeaf( word ? *word : ElementArray() );
+	word.reset();
+}
+
+void Permutation::FlattenWord( void )
+{
+	if( !wordProgram )
+		return;
+
+	std::unique_ptr<ElementArray> flatWord = std::make_unique<ElementArray>();
+	wordProgram->Flatten( *flatWord );
+	word = std::move( flatWord );
+	wordProgram.reset();
+}
+
+// This gives the word as a flat array, using the given one to flatten it into if need be.
+const ElementArray* Permutation::GetFlatWord( ElementArray& flatWord ) const
+{
+	if( !wordProgram )
+		return word.get();
+
+	flatWord.clear();
+	wordProgram->Flatten( flatWord );
+	return &flatWord;
 }
 
 bool Permutation::Factor( PermutationList& permutationList ) const
@@ -309,9 +1062,8 @@ bool Permutation::Factor( PermutationList& permutationList ) const
 
 	while( inputSet.Cardinality() > 0 )
 	{
-		NaturalNumberSet::UintSet::iterator iter = inputSet.set.begin();
-		uint i = *iter;
-		inputSet.set.erase( iter );
+		uint i = inputSet.Min();
+		inputSet.RemoveMember(i);
 
 		Permutation cycle;
 
@@ -355,11 +1107,11 @@ void Permutation::Print( std::ostream& ostream, bool isCycle /*= false*/ ) const
 	else
 	{
 		uint i;
-		for( i = 0; i < (uint)map.size(); i++ )
+		for( i = 0; i < map.Size(); i++ )
 			if( map[i] != i )
 				break;
 		
-		if( i < (uint)map.size() )
+		if( i < map.Size() )
 		{
 			ostream << "(";
 
@@ -382,7 +1134,14 @@ void Permutation::GetUnstableSet( NaturalNumberSet& unstableSet ) const
 {
 	unstableSet.RemoveAllMembers();
 
-	for( uint i = 0; i < (uint)map.size(); i++ )
+	if( supportState == SupportSparse )
+	{
+		for( uint i = 0; i < supportArray.size(); i++ )
+			unstableSet.AddMember( supportArray[i] );
+		return;
+	}
+
+	for( uint i = 0; i < map.Size(); i++ )
 		if( map[i] != i )
 			unstableSet.AddMember(i);
 }
@@ -391,7 +1150,7 @@ void Permutation::GetStableSet( NaturalNumberSet& stableSet ) const
 {
 	stableSet.RemoveAllMembers();
 
-	for( uint i = 0; i < (uint)map.size(); i++ )
+	for( uint i = 0; i < map.Size(); i++ )
 		if( map[i] == i )
 			stableSet.AddMember(i);
 }
@@ -401,24 +1160,48 @@ bool Permutation::operator==( const Permutation& permutation ) const
 	return IsEqualTo( permutation );
 }
 
-void Permutation::operator=( const Permutation& permutation )
+Permutation& Permutation::operator=( const Permutation& permutation )
 {
-	permutation.GetCopy( *this );
+	if( this != &permutation )
+		permutation.GetCopy( *this );
+	return *this;
+}
+
+// The moved-from permutation is left as the identity, with no word.
+Permutation& Permutation::operator=( Permutation&& permutation ) noexcept
+{
+	if( this == &permutation )
+		return *this;
+
+	moveCount.fetch_add( 1, std::memory_order_relaxed );
+
+	map = std::move( permutation.map );
+	word = std::move( permutation.word );
+	wordProgram = std::move( permutation.wordProgram );
+	cachedHash = permutation.cachedHash;
+	permutation.cachedHash = 0;
+	supportState = permutation.supportState;
+	supportArray = std::move( permutation.supportArray );
+	permutation.supportState = SupportUnknown;
+	return *this;
 }
 
 void Permutation::SetName( const std::string& name )
 {
-	word = std::make_unique<ElementList>();
+	word = std::make_unique<ElementArray>();
+	wordProgram.reset();
 
 	Element element;
-	element.name = name;
+	element.id = GeneratorAlphabet::Intern( name );
 	element.exponent = 1;
 	word->push_back( element );
 }
 
 std::string Permutation::GetName( void ) const
 {
-	if( !word.get() )
+	ElementArray flatWord;
+	const ElementArray* word = GetFlatWord( flatWord );
+	if( !word )
 		return "anonymous";
 
 	std::stringstream stream;
@@ -427,10 +1210,10 @@ std::string Permutation::GetName( void ) const
 		stream << "";
 	else
 	{
-		for( ElementList::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
+		for( ElementArray::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
 		{
 			const Element& element = *iter;
-			stream << element.name;
+			stream << GeneratorAlphabet::Name( element.id );
 			if( element.exponent != 1 )
 				stream << "^{" << element.exponent << "}";
 		}
@@ -439,58 +1222,67 @@ std::string Permutation::GetName( void ) const
 	return stream.str();
 }
 
+// Program words being compared are flattened into these.
+static thread_local ElementArray leftCompareWord;
+static thread_local ElementArray rightCompareWord;
+
+// Words are ordered by length, then element by element on their keys.  Flat words are compared
+// where they are, so a comparison costs no more than reading the two words.
 /*static*/ bool Permutation::LexigraphicCompare( const Permutation& permLeft, const Permutation& permRight )
 {
-	uint leftSize = permLeft.word ? ( uint )permLeft.word->size() : 0;
-	uint rightSize = permRight.word ? ( uint )permRight.word->size() : 0;
+	uint leftSize = permLeft.WordLength();
+	uint rightSize = permRight.WordLength();
 
 	if( leftSize < rightSize )
 		return true;
 	else if( leftSize > rightSize )
 		return false;
 
-	std::string leftKey = permLeft.MakeKeyForLexigraphicCompare();
-	std::string rightKey = permRight.MakeKeyForLexigraphicCompare();
-
-	int cmp = strcmp( leftKey.c_str(), rightKey.c_str() );
-	if( cmp < 0 )
-		return true;
-	return false;
-}
-
-std::string Permutation::MakeKeyForLexigraphicCompare( void ) const
-{
-	if( !word.get() || word->size() == 0 )
-		return "";
+	if( leftSize == 0 )
+		return false;
 
-	std::stringstream stream;
+	const ElementArray* leftWord = permLeft.GetFlatWord( leftCompareWord );
+	const ElementArray* rightWord = permRight.GetFlatWord( rightCompareWord );
 
-	for( ElementList::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
+	for( uint i = 0; i < leftSize; i++ )
 	{
-		const Element& element = *iter;
-		stream << element.name;
-		if( element.exponent > 0 )
-			stream << "p";
-		else
-			stream << "m";
-		stream << abs( element.exponent );
+		uint64_t leftKey = MakeElementKey( ( *leftWord )[i] );
+		uint64_t rightKey = MakeElementKey( ( *rightWord )[i] );
+
+		if( leftKey != rightKey )
+			return leftKey < rightKey;
 	}
 
-	return stream.str();
+	return false;
+}
+
+// Elements are ordered by generator, then with inverse powers first, then by the size of the exponent.
+/*static*/ uint64_t Permutation::MakeElementKey( const Element& element )
+{
+	uint64_t key = uint64_t( element.id ) << 32;
+	if( element.exponent > 0 )
+		key |= uint64_t(1) << 31;
+
+	// The magnitude of the least exponent doesn't fit in 31 bits, so it's counted with the next.
+	uint magnitude = ( element.exponent < 0 ) ? 0u - uint( element.exponent ) : uint( element.exponent );
+	key |= std::min( magnitude, uint( std::numeric_limits< int >::max() ) );
+	return key;
 }
 
 bool Permutation::GetToJsonValue( rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator ) const
 {
+	ElementArray flatWord;
+	const ElementArray* word = GetFlatWord( flatWord );
 	if( word )
 	{
 		rapidjson::Value wordArray( rapidjson::kArrayType );
 
-		for( ElementList::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
+		for( ElementArray::const_iterator iter = word->cbegin(); iter != word->cend(); iter++ )
 		{
 			const Element& element = *iter;
 						
 			rapidjson::Value stringValue( rapidjson::kStringType );
-			stringValue.SetString( element.name.c_str(), allocator );
+			stringValue.SetString( GeneratorAlphabet::Name( element.id ).c_str(), allocator );
 
 			rapidjson::Value elementValue( rapidjson::kObjectType );
 			elementValue.AddMember( "name", stringValue, allocator );
@@ -501,9 +1293,9 @@ bool Permutation::GetToJsonValue( rapidjson::Value& value, rapidjson::Document::
 		value.AddMember( "word", wordArray, allocator );
 	}
 
-	// We could certainly store this more compactly.
+	// This is far from compact, which is what the binary form is for.
 	rapidjson::Value mapArray( rapidjson::kArrayType );
-	for( uint i = 0; i < (uint)map.size(); i++ )
+	for( uint i = 0; i < map.Size(); i++ )
 		mapArray.PushBack( map[i], allocator );
 
 	value.AddMember( "map", mapArray, allocator );
@@ -514,19 +1306,21 @@ bool Permutation::GetToJsonValue( rapidjson::Value& value, rapidjson::Document::
 bool Permutation::SetFromJsonValue( /*const*/ rapidjson::Value& value )
 {
 	word.reset();
+	wordProgram.reset();
 
 	if( value.HasMember( "word" ) && value[ "word" ].IsArray() )
 	{
-		word = std::make_unique<ElementList>();
+		word = std::make_unique<ElementArray>();
 
 		rapidjson::Value& wordArray = value[ "word" ].GetArray();
+		word->reserve( wordArray.Size() );
 
 		for( uint i = 0; i < wordArray.Size(); i++ )
 		{
 			rapidjson::Value& elementValue = wordArray[i].GetObject();
 
 			Element element;
-			element.name = elementValue[ "name" ].GetString();
+			element.id = GeneratorAlphabet::Intern( elementValue[ "name" ].GetString() );
 			element.exponent = elementValue[ "exponent" ].GetInt();
 
 			word->push_back( element );
@@ -539,8 +1333,16 @@ bool Permutation::SetFromJsonValue( /*const*/ rapidjson::Value& value )
 	DefineIdentity();
 
 	rapidjson::Value& mapArray = value[ "map" ].GetArray();
+	if( mapArray.Size() > PointMap::maxDegree )
+		return false;
+
 	for (uint i = 0; i < mapArray.Size(); i++)
-		Define(i, mapArray[i].GetInt());
+	{
+		if( !mapArray[i].IsUint() || mapArray[i].GetUint() >= PointMap::maxDegree )
+			return false;
+
+		Define(i, mapArray[i].GetUint());
+	}
 
 	return true;
 }
@@ -575,6 +1377,26 @@ bool Permutation::SaveToJsonString( std::string& jsonString ) const
 	return true;
 }
 
+// See PermutationEncoder for the binary form.  A string holding anything more than the one
+// permutation isn't loaded.
+bool Permutation::LoadFromBinaryString( const std::string& binaryString )
+{
+	PermutationDecoder decoder( binaryString );
+	if( !decoder.DecodePermutation( *this ) )
+		return false;
+
+	return decoder.AtEnd();
+}
+
+bool Permutation::SaveToBinaryString( std::string& binaryString ) const
+{
+	binaryString.clear();
+
+	PermutationEncoder encoder( binaryString );
+	encoder.EncodePermutation( *this );
+	return true;
+}
+
 /*static*/ bool Permutation::LoadPermutationSet( PermutationSet& permutationSet, /*const*/ rapidjson::Value& arrayValue )
 {
 	permutationSet.clear();
@@ -587,7 +1409,7 @@ bool Permutation::SaveToJsonString( std::string& jsonString ) const
 		if( !permutation.SetFromJsonValue( permutationValue ) )
 			return false;
 
-		permutationSet.insert( permutation );
+		permutationSet.insert( std::move( permutation ) );
 	}
 
 	return true;
@@ -611,14 +1433,12 @@ bool Permutation::SaveToJsonString( std::string& jsonString ) const
 // It might be worth looking into what else can be done.
 bool Permutation::CompressWord( const CompressInfo& compressInfo )
 {
+	FlattenWord();
+
 	if( !word )
 		return false;
 
-	typedef std::vector< Element > ElementArray;
-	ElementArray elementArray;
-
-	for( ElementList::iterator iter = word->begin(); iter != word->end(); iter++ )
-		elementArray.push_back( *iter );
+	ElementArray& elementArray = *word;
 
 	bool combinedElements;
 
@@ -636,15 +1456,17 @@ bool Permutation::CompressWord( const CompressInfo& compressInfo )
 				uint k = ( j == 0 ) ? ( i - 1 ) : ( i + 1 );
 				while( k >= 0 && k < elementArray.size() )
 				{
-					Element& otherElement = elementArray[k];
+					const Element& otherElement = elementArray[k];
 
-					if( element.name == otherElement.name )
+					if( element.id == otherElement.id )
 					{
 						element.exponent += otherElement.exponent;
+						bool cancelled = ( element.exponent == 0 );
 
+						// Erasing the other element shifts this one down if it came after it.
 						elementArray.erase( elementArray.begin() + k );
-						if( element.exponent == 0 )
-							elementArray.erase( elementArray.begin() + i );
+						if( cancelled )
+							elementArray.erase( elementArray.begin() + ( k < i ? i - 1 : i ) );
 
 						combinedElements = true;
 						break;
@@ -660,21 +1482,16 @@ bool Permutation::CompressWord( const CompressInfo& compressInfo )
 	}
 	while( combinedElements );
 
-	word->clear();
+	uint count = 0;
 
 	for( uint i = 0; i < elementArray.size(); i++ )
 	{
-		Element& element = elementArray[i];
+		Element element = elementArray[i];
 
 		uint order = compressInfo.ElementOrder( element );
 
-		while( abs( element.exponent ) >= ( signed )order )
-		{
-			if( element.exponent > 0 )
-				element.exponent -= order;
-			else
-				element.exponent += order;
-		}
+		if( int( order ) > 0 )
+			element.exponent %= int( order );
 
 		if( element.exponent != 0 )
 		{
@@ -689,63 +1506,156 @@ bool Permutation::CompressWord( const CompressInfo& compressInfo )
 					element.exponent += order;
 			}
 
-			word->push_back( element );
+			elementArray[ count++ ] = element;
 		}
 	}
 
+	elementArray.resize( count );
+
 	return true;
 }
 
-bool CompressInfo::ElementsCommute( const Element& elementA, const Element& elementB ) const
+//------------------------------------------------------------------------------------------
+//                                      WordProgram
+//------------------------------------------------------------------------------------------
+
+/*static*/ WordProgramPtr WordProgram::MakeLeaf( const ElementArray& elementArray )
+{
+	std::shared_ptr< WordProgram > program = std::make_shared< WordProgram >();
+	program->elementArray = elementArray;
+	program->length = ( uint )elementArray.size();
+	return program;
+}
+
+// Empty factors are left out, and the product of a single uninverted factor is just that factor.
+/*static*/ WordProgramPtr WordProgram::MakeProduct( const FactorArray& factorArray )
 {
-	if( commuteMap.size() == 0 )
+	std::shared_ptr< WordProgram > program = std::make_shared< WordProgram >();
+	program->length = 0;
+	program->factorArray.reserve( factorArray.size() );
+
+	for( uint i = 0; i < factorArray.size(); i++ )
 	{
-		// Half of this is redundant, but that's fine.
-		for( PermutationMap::const_iterator iterA = permutationMap.cbegin(); iterA != permutationMap.cend(); iterA++ )
-		{
-			const Permutation& permA = iterA->second;
+		const Factor& factor = factorArray[i];
+		if( factor.program->length == 0 )
+			continue;
 
-			for( PermutationMap::const_iterator iterB = permutationMap.cbegin(); iterB != permutationMap.cend(); iterB++ )
-			{
-				const Permutation& permB = iterB->second;
+		program->factorArray.push_back( factor );
+		program->length += factor.program->length;
+	}
 
-				Permutation productAB;
-				productAB.Multiply( permA, permB );
+	if( program->factorArray.size() == 1 && !program->factorArray[0].inverse )
+		return program->factorArray[0].program;
 
-				Permutation productBA;
-				productBA.Multiply( permB, permA );
+	return program;
+}
 
-				bool commute = productAB.IsEqualTo( productBA );
-				std::string key = iterA->first + "*" + iterB->first;
-				commuteMap.insert( std::pair< std::string, bool >( key, commute ) );
-			}
+// The nodes are walked with an explicit stack, since a program built up one product at a
+// time can be much deeper than it is wide.
+void WordProgram::Flatten( ElementArray& elementArray, bool inverse /*= false*/ ) const
+{
+	elementArray.reserve( elementArray.size() + length );
+
+	// The stack is only needed for the length of this call.
+	typedef std::pair< const WordProgram*, bool > Node;
+	ScratchArena::Scope scratchScope;
+	std::vector< Node, ScratchAllocator< Node > > nodeStack;
+	nodeStack.push_back( Node( this, inverse ) );
+
+	while( nodeStack.size() > 0 )
+	{
+		const WordProgram* program = nodeStack.back().first;
+		bool inverted = nodeStack.back().second;
+		nodeStack.pop_back();
+
+		const FactorArray& factorArray = program->factorArray;
+
+		if( factorArray.size() == 0 )
+			AppendWord( elementArray, program->elementArray, inverted );
+		else if( !inverted )
+		{
+			// Factors are pushed in the reverse of the order they're to be flattened in.
+			for( uint i = ( uint )factorArray.size(); i-- > 0; )
+				nodeStack.push_back( Node( factorArray[i].program.get(), factorArray[i].inverse ) );
+		}
+		else
+		{
+			for( uint i = 0; i < factorArray.size(); i++ )
+				nodeStack.push_back( Node( factorArray[i].program.get(), !factorArray[i].inverse ) );
 		}
 	}
+}
 
-	CommuteMap::iterator iter = commuteMap.find( elementA.name + "*" + elementB.name );
-	if( iter == commuteMap.end() )
-		return false;
+//------------------------------------------------------------------------------------------
+//                                      CompressInfo
+//------------------------------------------------------------------------------------------
 
-	return iter->second;
+CompressInfo::CompressInfo( void )
+{
+	built = false;
+	alphabetSize = 0;
+	commuteRowSize = 0;
 }
 
-uint CompressInfo::ElementOrder( const Element& element ) const
+// The tables cover every id up to the largest one in the map.  Ids that aren't in the
+// map have no order and commute with nothing, as they did when looked up by name.
+void CompressInfo::Build( void ) const
 {
-	if( orderMap.size() == 0 )
+	std::vector< uint > idArray;
+	std::vector< const Permutation* > generatorArray;
+
+	alphabetSize = 0;
+	for( PermutationMap::const_iterator iter = permutationMap.cbegin(); iter != permutationMap.cend(); iter++ )
 	{
-		for( PermutationMap::const_iterator iter = permutationMap.cbegin(); iter != permutationMap.cend(); iter++ )
+		uint id = GeneratorAlphabet::Intern( iter->first );
+		idArray.push_back( id );
+		generatorArray.push_back( &iter->second );
+		alphabetSize = std::max( alphabetSize, id + 1 );
+	}
+
+	commuteRowSize = ( alphabetSize + 63 ) / 64;
+	orderArray.assign( alphabetSize, uint( -1 ) );
+	commuteMatrix.assign( std::size_t( alphabetSize ) * commuteRowSize, 0 );
+
+	for( uint i = 0; i < idArray.size(); i++ )
+	{
+		uint idA = idArray[i];
+		orderArray[ idA ] = generatorArray[i]->Order();
+
+		for( uint j = i; j < idArray.size(); j++ )
 		{
-			const Permutation& perm = iter->second;
-			uint order = perm.Order();
-			orderMap.insert( std::pair< std::string, uint >( iter->first, order ) );
+			uint idB = idArray[j];
+			if( i == j || generatorArray[i]->CommutesWith( *generatorArray[j] ) )
+			{
+				commuteMatrix[ std::size_t( idA ) * commuteRowSize + idB / 64 ] |= uint64_t( 1 ) << ( idB % 64 );
+				commuteMatrix[ std::size_t( idB ) * commuteRowSize + idA / 64 ] |= uint64_t( 1 ) << ( idA % 64 );
+			}
 		}
 	}
 
-	OrderMap::iterator iter = orderMap.find( element.name );
-	if( iter == orderMap.end() )
+	built = true;
+}
+
+bool CompressInfo::ElementsCommute( const Element& elementA, const Element& elementB ) const
+{
+	if( !built )
+		Build();
+
+	if( elementA.id >= alphabetSize || elementB.id >= alphabetSize )
+		return false;
+
+	return ( commuteMatrix[ std::size_t( elementA.id ) * commuteRowSize + elementB.id / 64 ] >> ( elementB.id % 64 ) ) & 1;
+}
+
+uint CompressInfo::ElementOrder( const Element& element ) const
+{
+	if( !built )
+		Build();
+
+	if( element.id >= alphabetSize )
 		return -1;
 
-	return iter->second;
+	return orderArray[ element.id ];
 }
 
 // Permutation.cpp
\ No newline at end of file
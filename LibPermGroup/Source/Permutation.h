@@ -2,47 +2,141 @@
 
 #pragma once
 
-#include <set>
 #include <list>
 #include <map>
 #include <vector>
 #include <string>
-#include <unordered_set>
 #include <memory>
+#include <atomic>
+#include <cstdint>
 #include "rapidjson/document.h"
 #include "NaturalNumberSet.h"
+#include "PointMap.h"
 
 class Permutation;
+class PermutationHashSet;
 
 typedef std::list< Permutation > PermutationList;
 typedef std::map< std::string, Permutation > PermutationMap;
 typedef std::vector< Permutation > PermutationArray;
 typedef std::vector< const Permutation* > PermutationConstPtrArray;
-typedef std::unordered_set< Permutation > PermutationSet;
-typedef std::set< Permutation > OrderedPermutationSet;
+typedef PermutationHashSet PermutationSet;
 
 typedef unsigned int uint;
 
+//------------------------------------------------------------------------------------------
+//                                    GeneratorAlphabet
+//------------------------------------------------------------------------------------------
+
+// Every generator name used in a word is interned here once, and words refer to it by
+// a small integer id from then on.  The names themselves are only needed again to print
+// a word or save it.  This is shared by all threads.
+class GeneratorAlphabet
+{
+public:
+
+	static uint Intern( const std::string& name );
+	static const std::string& Name( uint id );
+	static uint Size( void );
+};
+
 struct Element
 {
-	std::string name;
+	uint id;
 	int exponent;
 };
 
-typedef std::list< Element > ElementList;
-typedef std::map< std::string, uint > OrderMap;
-typedef std::map< std::string, bool > CommuteMap;
+typedef std::vector< Element > ElementArray;
+
+class WordProgram;
+
+typedef std::shared_ptr< const WordProgram > WordProgramPtr;
+typedef std::vector< WordProgramPtr > WordProgramArray;
+
+//------------------------------------------------------------------------------------------
+//                                      WordProgram
+//------------------------------------------------------------------------------------------
+
+// This is a word held as a straight-line program.  A node is either a flat word, or the
+// product of other nodes, any of which may be inverted.  Nodes are never changed once made,
+// so they are shared by every word built from them, and multiplying or copying a word held
+// this way costs the same however long it is.  It only gets flattened when its elements are
+// actually needed, such as to compress it or compare it with another word.
+class WordProgram
+{
+public:
+
+	struct Factor
+	{
+		WordProgramPtr program;
+		bool inverse;
+	};
+
+	typedef std::vector< Factor > FactorArray;
+
+	static WordProgramPtr MakeLeaf( const ElementArray& elementArray );
+	static WordProgramPtr MakeProduct( const FactorArray& factorArray );
+
+	// This appends the flattened word, or its inverse, to the given array.
+	void Flatten( ElementArray& elementArray, bool inverse = false ) const;
+
+	ElementArray elementArray;
+	FactorArray factorArray;
+
+	// Powers can make programs for words too long to count in 32 bits, let alone flatten.
+	uint64_t length;
+};
+
+//------------------------------------------------------------------------------------------
+//                                      CompressInfo
+//------------------------------------------------------------------------------------------
 
+// The orders of the generators, and which pairs of them commute, are looked up constantly
+// while compressing words, so they're held in flat tables indexed by generator id.  These
+// are made by Build from the permutation map, or on first use if Build wasn't called.
 class CompressInfo
 {
 public:
 
+	CompressInfo( void );
+
+	void Build( void ) const;
 	bool ElementsCommute( const Element& elementA, const Element& elementB ) const;
 	uint ElementOrder( const Element& element ) const;
 
-	mutable OrderMap orderMap;
-	mutable CommuteMap commuteMap;
 	PermutationMap permutationMap;
+
+	mutable bool built;
+	mutable uint alphabetSize;
+	mutable uint commuteRowSize;
+	mutable std::vector< uint > orderArray;
+	mutable std::vector< uint64_t > commuteMatrix;
+};
+
+//------------------------------------------------------------------------------------------
+//                                     CycleStructure
+//------------------------------------------------------------------------------------------
+
+// This is what a single walk over the cycles of a permutation finds out about it.
+// The order is the LCM of the cycle lengths, which can overflow even 64 bits for large
+// enough degrees, in which case it is flagged as such rather than wrapping around, and
+// the rest of the LCM is worked out exactly in the large order instead.
+struct CycleStructure
+{
+	// Entry i is the number of cycles of length i.  Fixed points aren't counted.
+	std::vector< uint > cycleCountArray;
+
+	uint64_t order;
+	bool orderOverflow;
+	BigUint largeOrder;
+	uint movedCount;
+	uint cycleCount;
+
+	bool IsEven( void ) const { return ( movedCount - cycleCount ) % 2 == 0; }
+	int Sign( void ) const { return IsEven() ? 1 : -1; }
+
+	// Here the identity has order one.
+	BigUint ExactOrder( void ) const { return orderOverflow ? largeOrder : BigUint( order == 0 ? 1 : order ); }
 };
 
 //------------------------------------------------------------------------------------------
@@ -60,7 +154,8 @@ public:
 
 	Permutation( void );
 	Permutation( const Permutation& permutation );
-	virtual ~Permutation( void );
+	Permutation( Permutation&& permutation ) noexcept;
+	~Permutation( void );
 
 	uint Evaluate( uint input ) const;
 	bool Stabilizes( const NaturalNumberSet& set ) const;
@@ -79,12 +174,18 @@ public:
 	bool IsEqualTo( const Permutation& permutation ) const;
 	bool CommutesWith( const Permutation& permutation ) const;
 	uint Order( void ) const;
+	bool GetOrder( BigUint& order ) const;
 	uint CycleOrder( void ) const;
+	int Sign( void ) const;
+	bool GetCycleStructure( CycleStructure& cycleStructure, bool countCycles = true ) const;
+	void Power( const Permutation& permutation, int exponent );
 	void SetCopy( const Permutation& permutation, bool copyWord = true );
 	void GetCopy( Permutation& permutation, bool copyWord = true ) const;
 	bool SetInverse( const Permutation& permutation );
 	bool GetInverse( Permutation& permutation ) const;
 	void Multiply( const Permutation& permutationA, const Permutation& permutationB );
+	bool MultiplyInverse( const Permutation& permutationA, const Permutation& permutationB );
+	void Conjugate( const Permutation& permutation, const Permutation& conjugator );
 	void MultiplyOnRight( const Permutation& permutation );
 	void MultiplyOnLeft( const Permutation& permutation );
 	bool Factor( PermutationList& permutationList ) const;
@@ -93,21 +194,74 @@ public:
 	std::size_t CalcHash( void ) const;
 	void Print( std::ostream& ostream, bool isCycle = false ) const;
 	bool operator==( const Permutation& permutation ) const;
-	void operator=( const Permutation& permutation );
+	Permutation& operator=( const Permutation& permutation );
+	Permutation& operator=( Permutation&& permutation ) noexcept;
 	void SetName( const std::string& name );
 	std::string GetName( void ) const;
 	bool GetToJsonValue( rapidjson::Value& value, rapidjson::Document::AllocatorType& allocator ) const;
 	bool SetFromJsonValue( /*const*/ rapidjson::Value& value );
 	bool CompressWord( const CompressInfo& compressInfo );
 	static bool LexigraphicCompare( const Permutation& permLeft, const Permutation& permRight );
-	std::string MakeKeyForLexigraphicCompare( void ) const;
+	static uint64_t MakeElementKey( const Element& element );
 	static bool LoadPermutationSet( PermutationSet& permutationSet, /*const*/ rapidjson::Value& arrayValue );
 	static bool SavePermutationSet( const PermutationSet& permutationSet, rapidjson::Value& arrayValue, rapidjson::Document::AllocatorType& allocator );
 	bool LoadFromJsonString( const std::string& jsonString );
 	bool SaveToJsonString( std::string& jsonString ) const;
+	bool LoadFromBinaryString( const std::string& binaryString );
+	bool SaveToBinaryString( std::string& binaryString ) const;
 
-	std::unique_ptr<ElementList> word;
-	std::vector< uint > map;
+	struct WordFactor
+	{
+		const Permutation* permutation;
+		bool inverse;
+	};
+
+	static void MultiplyWords( Permutation& product, std::initializer_list< WordFactor > factorList );
+	static void MultiplyWords( Permutation& product, const WordFactor* factorArray, uint factorCount );
+
+	// A permutation is sparse when no more than one in sparseRatio of the points below its
+	// size are moved by it.  Maps small enough to be held inline never count as sparse, other
+	// than the identity, since the kernels get through them as quickly as the moved points
+	// could be looked up.
+	bool IsSparse( void ) const;
+	void DefineSparse( const std::vector< uint >& pointArray, const std::vector< uint >& imageArray );
+
+	static const uint sparseRatio = 8;
+
+	// Every copy and every move of a permutation is counted here, so that the copying done by
+	// the containers and algorithms can be measured.  Copies go through GetCopy.
+	static std::atomic< uint64_t > copyCount;
+	static std::atomic< uint64_t > moveCount;
+
+	// A permutation's word is either flat, or a program, or it has none at all.  Products
+	// of permutations with program words get program words themselves.
+	bool HasWord( void ) const { return word || wordProgram; }
+
+	// A word too long to count in 32 bits is given the greatest length there is.
+	uint WordLength( void ) const;
+	void MakeWordProgram( void );
+	void FlattenWord( void );
+	const ElementArray* GetFlatWord( ElementArray& flatWord ) const;
+
+	std::unique_ptr<ElementArray> word;
+	WordProgramPtr wordProgram;
+	PointMap map;
+
+	// This is zero until the hash is first needed.  Anything that changes the map resets it.
+	mutable std::size_t cachedHash;
+
+	// The moved points of a sparse permutation are also kept here in increasing order, so that
+	// products, inverses and conjugates between sparse permutations only visit those points,
+	// however large the degree.  Like the hash, this is only worked out when first needed.
+	enum SupportState
+	{
+		SupportUnknown,
+		SupportDense,
+		SupportSparse
+	};
+
+	mutable SupportState supportState;
+	mutable std::vector< uint > supportArray;
 };
 
 namespace std
@@ -131,4 +285,7 @@ namespace std
 	};
 }
 
+// The set is made of permutations, so it can only be defined once they are.
+#include "PermutationHashSet.h"
+
 // Permutation.h
\ No newline at end of file
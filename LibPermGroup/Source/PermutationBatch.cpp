@@ -0,0 +1,285 @@
+// PermutationBatch.cpp
+
+#include "PermutationBatch.h"
+#include "PointMapKernels.h"
+#include <cstring>
+#include <algorithm>
+
+//------------------------------------------------------------------------------------------
+//                                    PermutationBatch
+//------------------------------------------------------------------------------------------
+
+// When the result of an operation overwrites rows that are still to be read, those rows
+// are copied here first.  Being per-thread and reused, it rarely needs to allocate.
+static thread_local std::vector< uint8_t > scratchRows;
+
+// A single permutation being applied to a whole batch is widened into a row here.
+static thread_local std::vector< uint8_t > scratchRow;
+
+static inline uint GetPoint( const uint8_t* row, uint width, uint i )
+{
+	switch( width )
+	{
+		case 1: return row[i];
+		case 2: return ( ( const uint16_t* )row )[i];
+	}
+	return ( ( const uint32_t* )row )[i];
+}
+
+static inline void SetPoint( uint8_t* row, uint width, uint i, uint x )
+{
+	switch( width )
+	{
+		case 1: row[i] = ( uint8_t )x; return;
+		case 2: ( ( uint16_t* )row )[i] = ( uint16_t )x; return;
+	}
+	( ( uint32_t* )row )[i] = x;
+}
+
+PermutationBatch::PermutationBatch( void )
+{
+	degree = 0;
+	count = 0;
+	SetDegree( 0 );
+}
+
+PermutationBatch::PermutationBatch( uint degree )
+{
+	this->degree = 0;
+	count = 0;
+	SetDegree( degree );
+}
+
+PermutationBatch::~PermutationBatch( void )
+{
+}
+
+void PermutationBatch::SetDegree( uint degree )
+{
+	this->degree = degree;
+	capacity = PointMap::CapacityForDegree( degree );
+	width = PointMap::WidthForCapacity( capacity );
+	stride = std::size_t( capacity ) * width;
+	count = 0;
+	data.clear();
+}
+
+/*static*/ uint PermutationBatch::Degree( const PermutationSet& permutationSet )
+{
+	uint degree = 0;
+	for( PermutationSet::const_iterator iter = permutationSet.cbegin(); iter != permutationSet.cend(); iter++ )
+		degree = std::max( degree, ( *iter ).map.Size() );
+	return degree;
+}
+
+void PermutationBatch::Clear( void )
+{
+	count = 0;
+	data.clear();
+}
+
+void PermutationBatch::Reserve( uint newCount )
+{
+	data.reserve( newCount * stride + PointMap::gatherSlack );
+}
+
+void PermutationBatch::Resize( uint newCount )
+{
+	data.resize( newCount * stride + PointMap::gatherSlack );
+
+	uint oldCount = count;
+	count = newCount;
+	FillIdentityRows( oldCount, newCount );
+}
+
+void PermutationBatch::FillIdentityRows( uint begin, uint end )
+{
+	for( uint i = begin; i < end; i++ )
+	{
+		uint8_t* row = Row(i);
+		for( uint j = 0; j < capacity; j++ )
+			SetPoint( row, width, j, j );
+	}
+}
+
+// The whole row is written, so it can be used as the second operand of a kernel.
+bool PermutationBatch::CopyToRow( const Permutation& permutation, uint8_t* row ) const
+{
+	const PointMap& map = permutation.map;
+	uint size = map.Size();
+	if( size > degree )
+		return false;
+
+	if( map.Width() == width )
+		memcpy( row, map.Data(), size * width );
+	else
+	{
+		for( uint i = 0; i < size; i++ )
+			SetPoint( row, width, i, map.Get(i) );
+	}
+
+	for( uint i = size; i < capacity; i++ )
+		SetPoint( row, width, i, i );
+
+	return true;
+}
+
+bool PermutationBatch::Add( const Permutation& permutation )
+{
+	if( permutation.map.Size() > degree )
+		return false;
+
+	Resize( count + 1 );
+	return CopyToRow( permutation, Row( count - 1 ) );
+}
+
+bool PermutationBatch::Set( uint i, const Permutation& permutation )
+{
+	if( i >= count )
+		return false;
+
+	return CopyToRow( permutation, Row(i) );
+}
+
+void PermutationBatch::Get( uint i, Permutation& permutation ) const
+{
+	PointMap& map = permutation.map;
+	map.Prepare( capacity, degree );
+	memcpy( map.Data(), Row(i), degree * width );
+	map.SetSize( degree );
+	map.Trim();
+
+	permutation.cachedHash = 0;
+	permutation.supportState = Permutation::SupportUnknown;
+	permutation.word.reset();
+	permutation.wordProgram.reset();
+}
+
+uint PermutationBatch::Evaluate( uint i, uint point ) const
+{
+	if( point >= degree )
+		return point;
+
+	return GetPoint( Row(i), width, point );
+}
+
+bool PermutationBatch::ComposeWithOne( const PermutationBatch& batch, const Permutation& permutation, bool onRight /*= true*/ )
+{
+	if( permutation.map.Size() > batch.degree )
+		return false;
+
+	scratchRow.resize( batch.stride + PointMap::gatherSlack );
+	batch.CopyToRow( permutation, scratchRow.data() );
+
+	const uint8_t* rows = batch.Row(0);
+	if( &batch != this )
+	{
+		if( degree != batch.degree )
+			SetDegree( batch.degree );
+		Resize( batch.count );
+	}
+	else if( !onRight )
+	{
+		// The batch is the table being looked up here, so it can't be overwritten as it goes.
+		scratchRows.assign( data.begin(), data.end() );
+		rows = scratchRows.data();
+	}
+
+	if( onRight )
+		PointMapKernels::ComposeRows( rows, stride, scratchRow.data(), 0, Row(0), count, degree, capacity );
+	else
+		PointMapKernels::ComposeRows( scratchRow.data(), 0, rows, stride, Row(0), count, degree, capacity );
+
+	return true;
+}
+
+bool PermutationBatch::ComposePairwise( const PermutationBatch& batchA, const PermutationBatch& batchB )
+{
+	if( batchA.degree != batchB.degree || batchA.count != batchB.count )
+		return false;
+
+	const uint8_t* rowsA = batchA.Row(0);
+	const uint8_t* rowsB = batchB.Row(0);
+
+	if( &batchB == this )
+	{
+		scratchRows.assign( data.begin(), data.end() );
+		rowsB = scratchRows.data();
+	}
+	else if( &batchA != this )
+	{
+		if( degree != batchA.degree )
+			SetDegree( batchA.degree );
+		Resize( batchA.count );
+	}
+
+	PointMapKernels::ComposeRows( rowsA, stride, rowsB, stride, Row(0), count, degree, capacity );
+	return true;
+}
+
+bool PermutationBatch::InvertAll( const PermutationBatch& batch )
+{
+	const uint8_t* rows = batch.Row(0);
+
+	if( &batch == this )
+	{
+		scratchRows.assign( data.begin(), data.end() );
+		rows = scratchRows.data();
+	}
+	else
+	{
+		// Rows are always fixed past the degree, which is what the kernel needs of them.
+		if( degree != batch.degree )
+			SetDegree( batch.degree );
+		Resize( batch.count );
+	}
+
+	return PointMapKernels::InvertRows( rows, Row(0), count, degree, capacity );
+}
+
+// The image of one point under every permutation is a strided walk down the array.
+void PermutationBatch::EvaluatePoint( uint point, std::vector< uint >& imageArray ) const
+{
+	imageArray.resize( count );
+
+	if( point >= degree )
+	{
+		std::fill( imageArray.begin(), imageArray.end(), point );
+		return;
+	}
+
+	for( uint i = 0; i < count; i++ )
+		imageArray[i] = GetPoint( Row(i), width, point );
+}
+
+// A permutation's hash is taken over its trimmed map at the width a map of that size would
+// have, so rows are trimmed here and, where a narrower width applies, narrowed first.
+void PermutationBatch::HashAll( std::vector< std::size_t >& hashArray ) const
+{
+	hashArray.resize( count );
+
+	for( uint i = 0; i < count; i++ )
+	{
+		const uint8_t* row = Row(i);
+
+		uint size = degree;
+		while( size > 0 && GetPoint( row, width, size - 1 ) == size - 1 )
+			size--;
+
+		uint hashWidth = PointMap::WidthForCapacity( PointMap::CapacityForDegree( size ) );
+		if( hashWidth != width )
+		{
+			// The hash reads whole words, so the narrowed row is padded out with fixed points.
+			uint paddedSize = ( size + 7 ) & ~7u;
+			scratchRow.resize( paddedSize * hashWidth );
+			for( uint j = 0; j < paddedSize; j++ )
+				SetPoint( scratchRow.data(), hashWidth, j, GetPoint( row, width, j ) );
+			row = scratchRow.data();
+		}
+
+		std::size_t hash = ( std::size_t )PointMapKernels::HashRow( row, size, hashWidth );
+		hashArray[i] = hash ? hash : 1;
+	}
+}
+
+// PermutationBatch.cpp
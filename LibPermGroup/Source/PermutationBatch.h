@@ -0,0 +1,70 @@
+// PermutationBatch.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <vector>
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------
+//                                    PermutationBatch
+//------------------------------------------------------------------------------------------
+
+// A batch holds any number of permutations of one degree in a single contiguous array, one
+// row of points after another.  Applying the same operation to every row then runs one
+// vector kernel down the whole array, rather than visiting separately allocated maps.
+// Rows carry no words; callers that need them can rebuild them with Permutation::MultiplyWords.
+class PermutationBatch
+{
+public:
+
+	PermutationBatch( void );
+	PermutationBatch( uint degree );
+	~PermutationBatch( void );
+
+	// Changing the degree empties the batch.
+	void SetDegree( uint degree );
+	uint Degree( void ) const { return degree; }
+	uint Count( void ) const { return count; }
+
+	void Clear( void );
+	void Reserve( uint newCount );
+	void Resize( uint newCount );
+
+	// These fail if the permutation moves a point at or beyond the degree of the batch.
+	bool Add( const Permutation& permutation );
+	bool Set( uint i, const Permutation& permutation );
+
+	void Get( uint i, Permutation& permutation ) const;
+	uint Evaluate( uint i, uint point ) const;
+
+	// The result of each of these replaces the contents of this batch, which may also be
+	// the batch (but not the single permutation) being operated on.
+	bool ComposeWithOne( const PermutationBatch& batch, const Permutation& permutation, bool onRight = true );
+	bool ComposePairwise( const PermutationBatch& batchA, const PermutationBatch& batchB );
+	bool InvertAll( const PermutationBatch& batch );
+
+	void EvaluatePoint( uint point, std::vector< uint >& imageArray ) const;
+
+	// Each hash is the same as the CalcHash of the permutation in that row.
+	void HashAll( std::vector< std::size_t >& hashArray ) const;
+
+	static uint Degree( const PermutationSet& permutationSet );
+
+private:
+
+	const uint8_t* Row( uint i ) const { return data.data() + std::size_t(i) * stride; }
+	uint8_t* Row( uint i ) { return data.data() + std::size_t(i) * stride; }
+
+	bool CopyToRow( const Permutation& permutation, uint8_t* row ) const;
+	void FillIdentityRows( uint begin, uint end );
+
+	uint degree;
+	uint capacity;
+	uint width;
+	std::size_t stride;
+	uint count;
+	std::vector< uint8_t > data;
+};
+
+// PermutationBatch.h
@@ -0,0 +1,462 @@
+// PermutationCodec.cpp
+
+#include "PermutationCodec.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationEncoder
+//------------------------------------------------------------------------------------------
+
+PermutationEncoder::PermutationEncoder( std::string& byteString )
+{
+	this->byteString = &byteString;
+	localIdCount = 0;
+}
+
+PermutationEncoder::~PermutationEncoder( void )
+{
+}
+
+void PermutationEncoder::EncodePermutation( const Permutation& permutation )
+{
+	// Trailing fixed points aren't written, so the degree is one more than the largest moved point.
+	uint degree = permutation.map.Size();
+	while( degree > 0 && permutation.map[ degree - 1 ] == degree - 1 )
+		degree--;
+
+	ElementArray flatWord;
+	const ElementArray* word = permutation.GetFlatWord( flatWord );
+
+	// The cycles are written aside first, so that they can be weighed against the images.
+	// Something that isn't a permutation has no cycles, so it can only be written as images.
+	bool cycles = false;
+	if( permutation.IsValid() )
+	{
+		cycleString.clear();
+		EncodeCycles( permutation, degree, cycleString );
+		cycles = ( cycleString.size() < std::size_t( degree ) * PointMap::WidthForCapacity( degree ) );
+	}
+
+	uint8_t tag = 0;
+	if( word )
+		tag |= TagHasWord;
+	if( cycles )
+		tag |= TagCycles;
+
+	EncodeByte( tag );
+	EncodeUint( degree );
+
+	if( cycles )
+		byteString->append( cycleString );
+	else
+		EncodeImages( permutation, degree );
+
+	if( word )
+		EncodeWord( *word );
+}
+
+void PermutationEncoder::EncodePermutationSet( const PermutationSet& permutationSet )
+{
+	EncodeUint( permutationSet.size() );
+
+	for( PermutationSet::const_iterator iter = permutationSet.cbegin(); iter != permutationSet.cend(); iter++ )
+		EncodePermutation( *iter );
+}
+
+void PermutationEncoder::EncodeImages( const Permutation& permutation, uint degree )
+{
+	uint width = PointMap::WidthForCapacity( degree );
+
+	for( uint i = 0; i < degree; i++ )
+	{
+		uint image = permutation.map[i];
+		for( uint j = 0; j < width; j++ )
+			EncodeByte( uint8_t( image >> ( 8 * j ) ) );
+	}
+}
+
+// Each cycle is written from its smallest point, as its length and then its points.
+void PermutationEncoder::EncodeCycles( const Permutation& permutation, uint degree, std::string& string )
+{
+	visitedArray.assign( degree, 0 );
+
+	uint cycleCount = 0;
+	for( uint i = 0; i < degree; i++ )
+	{
+		if( !visitedArray[i] && permutation.map[i] != i )
+		{
+			cycleCount++;
+			for( uint j = i; !visitedArray[j]; j = permutation.map[j] )
+				visitedArray[j] = 1;
+		}
+	}
+
+	AppendUint( string, cycleCount );
+
+	visitedArray.assign( degree, 0 );
+
+	for( uint i = 0; i < degree; i++ )
+	{
+		if( visitedArray[i] || permutation.map[i] == i )
+			continue;
+
+		uint length = 0;
+		for( uint j = i; !visitedArray[j]; j = permutation.map[j] )
+		{
+			visitedArray[j] = 1;
+			length++;
+		}
+
+		AppendUint( string, length );
+
+		uint j = i;
+		do
+		{
+			AppendUint( string, j );
+			j = permutation.map[j];
+		}
+		while( j != i );
+	}
+}
+
+void PermutationEncoder::EncodeWord( const ElementArray& word )
+{
+	EncodeUint( word.size() );
+
+	for( ElementArray::const_iterator iter = word.cbegin(); iter != word.cend(); iter++ )
+	{
+		const Element& element = *iter;
+
+		if( element.id >= localIdArray.size() )
+			localIdArray.resize( element.id + 1, 0 );
+
+		if( localIdArray[ element.id ] == 0 )
+		{
+			EncodeUint( localIdCount );
+			EncodeString( GeneratorAlphabet::Name( element.id ) );
+			localIdArray[ element.id ] = ++localIdCount;
+		}
+		else
+			EncodeUint( localIdArray[ element.id ] - 1 );
+
+		EncodeInt( element.exponent );
+	}
+}
+
+// The members are in increasing order, so each is written as its gap from the one before.
+void PermutationEncoder::EncodeSet( const NaturalNumberSet& set )
+{
+	EncodeUint( set.Cardinality() );
+
+	uint previous = 0;
+	for( NaturalNumberSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
+	{
+		EncodeUint( *iter - previous );
+		previous = *iter;
+	}
+}
+
+void PermutationEncoder::EncodeUint( uint64_t value )
+{
+	AppendUint( *byteString, value );
+}
+
+// Zig-zag encoding interleaves the negative numbers with the positive ones, so that small
+// exponents of either sign make small varints.
+void PermutationEncoder::EncodeInt( int value )
+{
+	EncodeUint( ( uint32_t( value ) << 1 ) ^ uint32_t( value >> 31 ) );
+}
+
+void PermutationEncoder::EncodeByte( uint8_t value )
+{
+	byteString->push_back( char( value ) );
+}
+
+/*static*/ void PermutationEncoder::AppendUint( std::string& string, uint64_t value )
+{
+	while( value >= 0x80 )
+	{
+		string.push_back( char( uint8_t( value | 0x80 ) ) );
+		value >>= 7;
+	}
+
+	string.push_back( char( uint8_t( value ) ) );
+}
+
+void PermutationEncoder::EncodeString( const std::string& string )
+{
+	EncodeUint( string.size() );
+	byteString->append( string );
+}
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationDecoder
+//------------------------------------------------------------------------------------------
+
+PermutationDecoder::PermutationDecoder( const std::string& byteString, std::size_t offset /*= 0*/ )
+{
+	this->byteString = &byteString;
+	this->offset = offset;
+}
+
+PermutationDecoder::~PermutationDecoder( void )
+{
+}
+
+void PermutationDecoder::Reset( std::size_t offset /*= 0*/ )
+{
+	this->offset = offset;
+	idArray.clear();
+}
+
+bool PermutationDecoder::DecodePermutation( Permutation& permutation )
+{
+	permutation.word.reset();
+	permutation.wordProgram.reset();
+	permutation.DefineIdentity();
+
+	uint8_t tag = 0;
+	if( !DecodeByte( tag ) || ( tag & ~( PermutationEncoder::TagHasWord | PermutationEncoder::TagCycles ) ) != 0 )
+		return false;
+
+	uint degree = 0;
+	if( !DecodeUint( degree ) )
+		return false;
+
+	if( degree > PointMap::maxDegree )
+		return false;
+
+	if( tag & PermutationEncoder::TagCycles )
+	{
+		// Every cycle takes at least a byte for its length and one for each of its two or more points.
+		uint cycleCount = 0;
+		if( !DecodeUint( cycleCount ) || cycleCount > ( byteString->size() - offset ) / 3 )
+			return false;
+
+		// The cycles are read aside and checked before anything is allocated for the degree.
+		// The encoder only writes the degree as one past the largest point moved, so anything
+		// else is rejected, and the degree can't be made any bigger than the points read.
+		cyclePointArray.clear();
+		cycleLengthArray.clear();
+
+		uint maxPoint = 0;
+		for( uint i = 0; i < cycleCount; i++ )
+		{
+			uint length = 0;
+			if( !DecodeUint( length ) || length < 2 || length > degree || length > byteString->size() - offset )
+				return false;
+
+			for( uint j = 0; j < length; j++ )
+			{
+				uint point = 0;
+				if( !DecodeUint( point ) || point >= degree )
+					return false;
+
+				cyclePointArray.push_back( point );
+				maxPoint = std::max( maxPoint, point );
+			}
+
+			cycleLengthArray.push_back( length );
+		}
+
+		if( degree != ( ( cycleCount > 0 ) ? maxPoint + 1 : 0 ) )
+			return false;
+
+		// No point can be in more than one cycle, or more than once in the same one.
+		sortedPointArray = cyclePointArray;
+		std::sort( sortedPointArray.begin(), sortedPointArray.end() );
+		if( std::adjacent_find( sortedPointArray.begin(), sortedPointArray.end() ) != sortedPointArray.end() )
+			return false;
+
+		permutation.map.Reserve( degree );
+
+		uint first = 0;
+		for( uint i = 0; i < cycleLengthArray.size(); i++ )
+		{
+			uint length = cycleLengthArray[i];
+			for( uint j = 0; j < length; j++ )
+				permutation.Define( cyclePointArray[ first + j ], cyclePointArray[ first + ( j + 1 ) % length ] );
+
+			first += length;
+		}
+	}
+	else
+	{
+		uint width = PointMap::WidthForCapacity( degree );
+		if( std::size_t( degree ) * width > byteString->size() - offset )
+			return false;
+
+		permutation.map.Reserve( degree );
+
+		const uint8_t* data = ( const uint8_t* )byteString->data() + offset;
+		for( uint i = 0; i < degree; i++ )
+		{
+			uint image = 0;
+			for( uint j = 0; j < width; j++ )
+				image |= uint( data[ i * width + j ] ) << ( 8 * j );
+
+			if( image >= degree )
+				return false;
+
+			permutation.Define( i, image );
+		}
+
+		offset += std::size_t( degree ) * width;
+
+		if( !permutation.IsValid() )
+			return false;
+	}
+
+	if( tag & PermutationEncoder::TagHasWord )
+	{
+		permutation.word = std::make_unique< ElementArray >();
+		if( !DecodeWord( *permutation.word ) )
+			return false;
+	}
+
+	return true;
+}
+
+bool PermutationDecoder::DecodePermutationSet( PermutationSet& permutationSet )
+{
+	permutationSet.clear();
+
+	uint count = 0;
+	if( !DecodeUint( count ) || count > byteString->size() - offset )
+		return false;
+
+	permutationSet.reserve( count );
+
+	for( uint i = 0; i < count; i++ )
+	{
+		Permutation permutation;
+		if( !DecodePermutation( permutation ) )
+			return false;
+
+		permutationSet.insert( std::move( permutation ) );
+	}
+
+	return true;
+}
+
+bool PermutationDecoder::DecodeWord( ElementArray& word )
+{
+	word.clear();
+
+	uint length = 0;
+	if( !DecodeUint( length ) || length > byteString->size() - offset )
+		return false;
+
+	word.reserve( length );
+
+	for( uint i = 0; i < length; i++ )
+	{
+		uint localId = 0;
+		if( !DecodeUint( localId ) || localId > idArray.size() )
+			return false;
+
+		if( localId == idArray.size() )
+		{
+			std::string name;
+			if( !DecodeString( name ) )
+				return false;
+
+			idArray.push_back( GeneratorAlphabet::Intern( name ) );
+		}
+
+		Element element;
+		element.id = idArray[ localId ];
+		if( !DecodeInt( element.exponent ) )
+			return false;
+
+		word.push_back( element );
+	}
+
+	return true;
+}
+
+bool PermutationDecoder::DecodeSet( NaturalNumberSet& set )
+{
+	set.RemoveAllMembers();
+
+	uint count = 0;
+	if( !DecodeUint( count ) )
+		return false;
+
+	uint64_t member = 0;
+	for( uint i = 0; i < count; i++ )
+	{
+		uint gap = 0;
+		if( !DecodeUint( gap ) || ( i > 0 && gap == 0 ) )
+			return false;
+
+		member += gap;
+		if( member > 0xFFFFFFFF )
+			return false;
+
+		set.AddMember( uint( member ) );
+	}
+
+	return true;
+}
+
+bool PermutationDecoder::DecodeUint( uint64_t& value )
+{
+	value = 0;
+
+	for( uint shift = 0; shift < 64; shift += 7 )
+	{
+		uint8_t byte = 0;
+		if( !DecodeByte( byte ) )
+			return false;
+
+		value |= uint64_t( byte & 0x7F ) << shift;
+		if( ( byte & 0x80 ) == 0 )
+			return true;
+	}
+
+	return false;
+}
+
+bool PermutationDecoder::DecodeUint( uint& value )
+{
+	uint64_t largeValue = 0;
+	if( !DecodeUint( largeValue ) || largeValue > 0xFFFFFFFF )
+		return false;
+
+	value = uint( largeValue );
+	return true;
+}
+
+bool PermutationDecoder::DecodeInt( int& value )
+{
+	uint zigZag = 0;
+	if( !DecodeUint( zigZag ) )
+		return false;
+
+	value = int( ( zigZag >> 1 ) ^ ( 0 - ( zigZag & 1 ) ) );
+	return true;
+}
+
+bool PermutationDecoder::DecodeByte( uint8_t& value )
+{
+	if( offset >= byteString->size() )
+		return false;
+
+	value = uint8_t( ( *byteString )[ offset++ ] );
+	return true;
+}
+
+bool PermutationDecoder::DecodeString( std::string& string )
+{
+	uint length = 0;
+	if( !DecodeUint( length ) || length > byteString->size() - offset )
+		return false;
+
+	string.assign( *byteString, offset, length );
+	offset += length;
+	return true;
+}
+
+// PermutationCodec.cpp
@@ -0,0 +1,105 @@
+// PermutationCodec.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationEncoder
+//------------------------------------------------------------------------------------------
+
+// This is a compact binary alternative to the JSON form of permutations and their words.
+// Numbers are written as varints, seven bits to a byte, so small ones take a single byte.
+// A permutation's map is written either as its images, each in the fewest whole bytes able to
+// hold any point below its degree, or as its cycles, whichever takes less room.  A word's
+// elements are generator ids and zig-zag encoded exponents.  The ids are local to the encoded
+// bytes: a generator's name is written out the first time it's used, and from then on it's
+// referred to by the order in which it first appeared.  The encoded bytes are appended to the
+// given string, and any number of permutations can share an encoder, and so its names.
+class PermutationEncoder
+{
+public:
+
+	PermutationEncoder( std::string& byteString );
+	~PermutationEncoder( void );
+
+	void EncodePermutation( const Permutation& permutation );
+	void EncodePermutationSet( const PermutationSet& permutationSet );
+	void EncodeWord( const ElementArray& word );
+	void EncodeSet( const NaturalNumberSet& set );
+	void EncodeUint( uint64_t value );
+	void EncodeInt( int value );
+	void EncodeByte( uint8_t value );
+	void EncodeString( const std::string& string );
+
+	// A permutation starts with a byte made of these.
+	enum Tag
+	{
+		TagHasWord = 0x01,
+		TagCycles = 0x02
+	};
+
+	std::string* byteString;
+
+	// Entry i is one more than the local id of the generator with id i, or zero if that
+	// generator hasn't been written yet.
+	std::vector< uint > localIdArray;
+	uint localIdCount;
+
+private:
+
+	void EncodeImages( const Permutation& permutation, uint degree );
+	void EncodeCycles( const Permutation& permutation, uint degree, std::string& string );
+
+	static void AppendUint( std::string& string, uint64_t value );
+
+	std::string cycleString;
+	std::vector< uint8_t > visitedArray;
+};
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationDecoder
+//------------------------------------------------------------------------------------------
+
+// This reads back what the encoder wrote, in the same order.  Everything read is checked
+// against the end of the bytes, and each of these fails rather than reading past it, or
+// making a permutation out of anything that isn't one.
+class PermutationDecoder
+{
+public:
+
+	PermutationDecoder( const std::string& byteString, std::size_t offset = 0 );
+	~PermutationDecoder( void );
+
+	bool DecodePermutation( Permutation& permutation );
+	bool DecodePermutationSet( PermutationSet& permutationSet );
+	bool DecodeWord( ElementArray& word );
+	bool DecodeSet( NaturalNumberSet& set );
+	bool DecodeUint( uint64_t& value );
+	bool DecodeUint( uint& value );
+	bool DecodeInt( int& value );
+	bool DecodeByte( uint8_t& value );
+	bool DecodeString( std::string& string );
+
+	bool AtEnd( void ) const { return offset >= byteString->size(); }
+
+	// This starts over from the given offset, forgetting every name read so far.
+	void Reset( std::size_t offset = 0 );
+
+	const std::string* byteString;
+	std::size_t offset;
+
+	// Entry i is the generator id of local id i.
+	std::vector< uint > idArray;
+
+private:
+
+	std::vector< uint > cyclePointArray;
+	std::vector< uint > cycleLengthArray;
+	std::vector< uint > sortedPointArray;
+};
+
+// PermutationCodec.h
@@ -0,0 +1,63 @@
+// PermutationExpression.cpp
+
+#include "PermutationExpression.h"
+#include "PointMapKernels.h"
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+//                                     PermutationTerm
+//------------------------------------------------------------------------------------------
+
+// The inverses of the inverted factors of an expression being written out are made here.
+// Being per-thread and reused, they rarely need to allocate.
+static thread_local std::vector< PointMap > scratchInverseArray;
+
+static thread_local PointMap scratchMap;
+
+static thread_local std::vector< uint > scratchPointArray;
+static thread_local std::vector< uint > scratchImageArray;
+
+// The point's preimage is the point just before it on its cycle.
+uint PermutationTerm::WalkPreimage( uint point ) const
+{
+	uint preimage = point;
+	uint image = permutation->Evaluate( preimage );
+
+	while( image != point )
+	{
+		preimage = image;
+		image = permutation->Evaluate( preimage );
+	}
+
+	return preimage;
+}
+
+const PointMap* PermutationTerm::MakeInverse( uint scratchIndex ) const
+{
+	PointMap& inverseMap = scratchInverseArray[ scratchIndex ];
+	PointMapKernels::Invert( permutation->map, inverseMap );
+	return &inverseMap;
+}
+
+/*static*/ PointMap& PermutationTerm::ScratchMap( void )
+{
+	return scratchMap;
+}
+
+/*static*/ std::vector< uint >& PermutationTerm::ScratchPointArray( void )
+{
+	return scratchPointArray;
+}
+
+/*static*/ std::vector< uint >& PermutationTerm::ScratchImageArray( void )
+{
+	return scratchImageArray;
+}
+
+/*static*/ void PermutationTerm::ReserveScratchInverses( uint count )
+{
+	if( scratchInverseArray.size() < count )
+		scratchInverseArray.resize( count );
+}
+
+// PermutationExpression.cpp
\ No newline at end of file
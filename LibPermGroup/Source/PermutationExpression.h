@@ -0,0 +1,347 @@
+// PermutationExpression.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------------------
+//                                  PermutationExpression
+//------------------------------------------------------------------------------------------
+
+// Products, inverses, conjugates and commutators of permutations can be written here as
+// expressions, such as a * b * Inverse(c), that are not evaluated when they're written.
+// The type of an expression records its whole shape, so that the image of a point under
+// it is found by the compiler threading the point through each factor in turn.  Often only
+// a few points need to be looked at, such as whether the expression fixes the base points
+// of a group, and then nothing is ever multiplied out.  When the whole permutation is
+// wanted, GetPermutation writes it in a single pass with no intermediate products.
+//
+// As with Permutation::Multiply, a * b applies a first and then b.  Expressions only refer
+// to the permutations they're made from, which must outlive them.
+template< typename Expression >
+class PermutationExpression
+{
+public:
+
+	const Expression& Derived( void ) const { return static_cast< const Expression& >( *this ); }
+
+	// The image of the given point.
+	uint Evaluate( uint point ) const { return Derived().Evaluate( point ); }
+
+	// Whether the point is its own image.  A product is split so that the inverse of its
+	// right-hand side is looked up instead of what lies to its left, which for a * Inverse(b)
+	// just compares a(x) with b(x).
+	bool Fixes( uint point ) const { return Derived().Fixes( point ); }
+
+	bool Stabilizes( const NaturalNumberSet& set ) const
+	{
+		for( NaturalNumberSet::const_iterator iter = set.cbegin(); iter != set.cend(); iter++ )
+			if( !Fixes( *iter ) )
+				return false;
+
+		return true;
+	}
+
+	bool IsIdentity( void ) const;
+
+	bool IsEqualTo( const Permutation& permutation ) const
+	{
+		uint bound = std::max( Derived().Bound(), permutation.map.Size() );
+		for( uint i = 0; i < bound; i++ )
+			if( Evaluate(i) != permutation.Evaluate(i) )
+				return false;
+
+		return true;
+	}
+
+	void GetPermutation( Permutation& permutation ) const;
+};
+
+//------------------------------------------------------------------------------------------
+//                                     PermutationTerm
+//------------------------------------------------------------------------------------------
+
+// This is a single permutation appearing in an expression.  Wherever it appears inverted,
+// images under its inverse are found by walking back around the cycle of the point.  When
+// the whole expression is being written out, its inverse is made once beforehand instead.
+class PermutationTerm : public PermutationExpression< PermutationTerm >
+{
+public:
+
+	PermutationTerm( const Permutation& permutation ) : permutation( &permutation ), inverseMap( nullptr ) {}
+
+	uint Evaluate( uint point ) const { return permutation->Evaluate( point ); }
+	bool Fixes( uint point ) const { return Evaluate( point ) == point; }
+
+	uint Preimage( uint point ) const
+	{
+		if( inverseMap )
+			return ( point < inverseMap->Capacity() ) ? inverseMap->Get( point ) : point;
+
+		return WalkPreimage( point );
+	}
+
+	uint Bound( void ) const { return permutation->map.Size(); }
+	bool References( const Permutation* other ) const { return permutation == other; }
+	bool IsSparse( void ) const { return permutation->IsSparse(); }
+
+	void GatherSupport( std::vector< uint >& pointArray ) const
+	{
+		pointArray.insert( pointArray.end(), permutation->supportArray.cbegin(), permutation->supportArray.cend() );
+	}
+
+	static const uint factorCount = 1;
+
+	void GetFactors( Permutation::WordFactor*& factor, bool inverse ) const
+	{
+		factor->permutation = permutation;
+		factor->inverse = inverse;
+		factor++;
+	}
+
+	void PrepareInverses( uint& scratchIndex, bool inverse ) const
+	{
+		if( inverse )
+			inverseMap = MakeInverse( scratchIndex++ );
+	}
+
+	void ReleaseInverses( void ) const { inverseMap = nullptr; }
+
+	uint WalkPreimage( uint point ) const;
+	const PointMap* MakeInverse( uint scratchIndex ) const;
+
+	const Permutation* permutation;
+	mutable const PointMap* inverseMap;
+
+	// Written-out expressions are made here first when they refer to the permutation being written.
+	static PointMap& ScratchMap( void );
+	static void ReserveScratchInverses( uint count );
+
+	// The points moved by the factors of a sparse expression, and their images, are gathered here.
+	static std::vector< uint >& ScratchPointArray( void );
+	static std::vector< uint >& ScratchImageArray( void );
+};
+
+//------------------------------------------------------------------------------------------
+//                                   InverseExpression
+//------------------------------------------------------------------------------------------
+
+template< typename Operand >
+class InverseExpression : public PermutationExpression< InverseExpression< Operand > >
+{
+public:
+
+	InverseExpression( const Operand& operand ) : operand( operand ) {}
+
+	uint Evaluate( uint point ) const { return operand.Preimage( point ); }
+	uint Preimage( uint point ) const { return operand.Evaluate( point ); }
+	bool Fixes( uint point ) const { return operand.Fixes( point ); }
+
+	uint Bound( void ) const { return operand.Bound(); }
+	bool References( const Permutation* other ) const { return operand.References( other ); }
+	bool IsSparse( void ) const { return operand.IsSparse(); }
+	void GatherSupport( std::vector< uint >& pointArray ) const { operand.GatherSupport( pointArray ); }
+
+	static const uint factorCount = Operand::factorCount;
+
+	void GetFactors( Permutation::WordFactor*& factor, bool inverse ) const { operand.GetFactors( factor, !inverse ); }
+	void PrepareInverses( uint& scratchIndex, bool inverse ) const { operand.PrepareInverses( scratchIndex, !inverse ); }
+	void ReleaseInverses( void ) const { operand.ReleaseInverses(); }
+
+	Operand operand;
+};
+
+//------------------------------------------------------------------------------------------
+//                                   ProductExpression
+//------------------------------------------------------------------------------------------
+
+template< typename Left, typename Right >
+class ProductExpression : public PermutationExpression< ProductExpression< Left, Right > >
+{
+public:
+
+	ProductExpression( const Left& left, const Right& right ) : left( left ), right( right ) {}
+
+	uint Evaluate( uint point ) const { return right.Evaluate( left.Evaluate( point ) ); }
+	uint Preimage( uint point ) const { return left.Preimage( right.Preimage( point ) ); }
+	bool Fixes( uint point ) const { return left.Evaluate( point ) == right.Preimage( point ); }
+
+	uint Bound( void ) const { return std::max( left.Bound(), right.Bound() ); }
+	bool References( const Permutation* other ) const { return left.References( other ) || right.References( other ); }
+	bool IsSparse( void ) const { return left.IsSparse() && right.IsSparse(); }
+
+	void GatherSupport( std::vector< uint >& pointArray ) const
+	{
+		left.GatherSupport( pointArray );
+		right.GatherSupport( pointArray );
+	}
+
+	static const uint factorCount = Left::factorCount + Right::factorCount;
+
+	// The inverse of a product is the product of the inverses in the opposite order.
+	void GetFactors( Permutation::WordFactor*& factor, bool inverse ) const
+	{
+		if( !inverse )
+		{
+			left.GetFactors( factor, false );
+			right.GetFactors( factor, false );
+		}
+		else
+		{
+			right.GetFactors( factor, true );
+			left.GetFactors( factor, true );
+		}
+	}
+
+	void PrepareInverses( uint& scratchIndex, bool inverse ) const
+	{
+		left.PrepareInverses( scratchIndex, inverse );
+		right.PrepareInverses( scratchIndex, inverse );
+	}
+
+	void ReleaseInverses( void ) const
+	{
+		left.ReleaseInverses();
+		right.ReleaseInverses();
+	}
+
+	Left left;
+	Right right;
+};
+
+//------------------------------------------------------------------------------------------
+//                                  Expression operators
+//------------------------------------------------------------------------------------------
+
+inline ProductExpression< PermutationTerm, PermutationTerm > operator*( const Permutation& left, const Permutation& right )
+{
+	return ProductExpression< PermutationTerm, PermutationTerm >( PermutationTerm( left ), PermutationTerm( right ) );
+}
+
+template< typename Right >
+ProductExpression< PermutationTerm, Right > operator*( const Permutation& left, const PermutationExpression< Right >& right )
+{
+	return ProductExpression< PermutationTerm, Right >( PermutationTerm( left ), right.Derived() );
+}
+
+template< typename Left >
+ProductExpression< Left, PermutationTerm > operator*( const PermutationExpression< Left >& left, const Permutation& right )
+{
+	return ProductExpression< Left, PermutationTerm >( left.Derived(), PermutationTerm( right ) );
+}
+
+template< typename Left, typename Right >
+ProductExpression< Left, Right > operator*( const PermutationExpression< Left >& left, const PermutationExpression< Right >& right )
+{
+	return ProductExpression< Left, Right >( left.Derived(), right.Derived() );
+}
+
+inline InverseExpression< PermutationTerm > Inverse( const Permutation& permutation )
+{
+	return InverseExpression< PermutationTerm >( PermutationTerm( permutation ) );
+}
+
+template< typename Operand >
+InverseExpression< Operand > Inverse( const PermutationExpression< Operand >& operand )
+{
+	return InverseExpression< Operand >( operand.Derived() );
+}
+
+// This is the inverse of the conjugator, followed by the permutation, followed by the
+// conjugator, the same as Permutation::Conjugate.
+inline ProductExpression< ProductExpression< InverseExpression< PermutationTerm >, PermutationTerm >, PermutationTerm > Conjugate( const Permutation& permutation, const Permutation& conjugator )
+{
+	return Inverse( conjugator ) * permutation * conjugator;
+}
+
+// This is a, then b, then the inverse of a, then the inverse of b.
+inline ProductExpression< ProductExpression< ProductExpression< PermutationTerm, PermutationTerm >, InverseExpression< PermutationTerm > >, InverseExpression< PermutationTerm > > Commutator( const Permutation& permutationA, const Permutation& permutationB )
+{
+	return permutationA * permutationB * Inverse( permutationA ) * Inverse( permutationB );
+}
+
+// Every point at or past the bound is fixed by every factor.  When every factor is sparse,
+// only the points they move need to be looked at.
+template< typename Expression >
+bool PermutationExpression< Expression >::IsIdentity( void ) const
+{
+	if( Derived().IsSparse() )
+	{
+		std::vector< uint >& pointArray = PermutationTerm::ScratchPointArray();
+		pointArray.clear();
+		Derived().GatherSupport( pointArray );
+
+		for( uint i = 0; i < pointArray.size(); i++ )
+			if( !Fixes( pointArray[i] ) )
+				return false;
+
+		return true;
+	}
+
+	uint bound = Derived().Bound();
+	for( uint i = 0; i < bound; i++ )
+		if( !Fixes(i) )
+			return false;
+
+	return true;
+}
+
+// The expression is written out one point at a time, every factor being looked up in turn
+// for each point.  Only the inverses of inverted factors are made beforehand, into storage
+// that is reused from one expression to the next.  If every factor is sparse, only the
+// points they move are written, and inverses are just walked around their short cycles.
+template< typename Expression >
+void PermutationExpression< Expression >::GetPermutation( Permutation& permutation ) const
+{
+	const Expression& expression = Derived();
+
+	Permutation::WordFactor factorArray[ Expression::factorCount ];
+	Permutation::WordFactor* factor = factorArray;
+	expression.GetFactors( factor, false );
+
+	if( expression.IsSparse() )
+	{
+		std::vector< uint >& pointArray = PermutationTerm::ScratchPointArray();
+		pointArray.clear();
+		expression.GatherSupport( pointArray );
+		std::sort( pointArray.begin(), pointArray.end() );
+		pointArray.erase( std::unique( pointArray.begin(), pointArray.end() ), pointArray.end() );
+
+		std::vector< uint >& imageArray = PermutationTerm::ScratchImageArray();
+		imageArray.resize( pointArray.size() );
+		for( uint i = 0; i < pointArray.size(); i++ )
+			imageArray[i] = expression.Evaluate( pointArray[i] );
+
+		permutation.DefineSparse( pointArray, imageArray );
+		Permutation::MultiplyWords( permutation, factorArray, Expression::factorCount );
+		return;
+	}
+
+	PermutationTerm::ReserveScratchInverses( Expression::factorCount );
+	uint scratchIndex = 0;
+	expression.PrepareInverses( scratchIndex, false );
+
+	PointMap* map = &permutation.map;
+	if( expression.References( &permutation ) )
+		map = &PermutationTerm::ScratchMap();
+
+	uint bound = expression.Bound();
+	map->Prepare( PointMap::CapacityForDegree( bound ), 0 );
+	for( uint i = 0; i < bound; i++ )
+		map->Set( i, expression.Evaluate(i) );
+	map->SetSize( bound );
+	map->Trim();
+
+	expression.ReleaseInverses();
+
+	Permutation::MultiplyWords( permutation, factorArray, Expression::factorCount );
+
+	if( map != &permutation.map )
+		permutation.map = *map;
+
+	permutation.cachedHash = 0;
+	permutation.supportState = Permutation::SupportUnknown;
+}
+
+// PermutationExpression.h
@@ -0,0 +1,423 @@
+// PermutationHashSet.cpp
+
+#include "PermutationHashSet.h"
+#include <new>
+#include <memory>
+#include <cstring>
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationHashSet
+//------------------------------------------------------------------------------------------
+
+PermutationHashSet::PermutationHashSet( void )
+{
+	handleCount = 0;
+	count = 0;
+	bucketMask = 0;
+	firstHandle = 0;
+}
+
+PermutationHashSet::PermutationHashSet( const PermutationHashSet& permutationSet ) : PermutationHashSet()
+{
+	*this = permutationSet;
+}
+
+PermutationHashSet::PermutationHashSet( PermutationHashSet&& permutationSet ) noexcept : PermutationHashSet()
+{
+	*this = std::move( permutationSet );
+}
+
+PermutationHashSet::~PermutationHashSet( void )
+{
+	Destroy();
+}
+
+// The copy gets its own slab, packed in the order the permutations are iterated.
+PermutationHashSet& PermutationHashSet::operator=( const PermutationHashSet& permutationSet )
+{
+	if( this != &permutationSet )
+	{
+		clear();
+		reserve( permutationSet.size() );
+		for( const_iterator iter = permutationSet.cbegin(); iter != permutationSet.cend(); iter++ )
+			insert( *iter );
+	}
+
+	return *this;
+}
+
+// The moved-from set is left empty.
+PermutationHashSet& PermutationHashSet::operator=( PermutationHashSet&& permutationSet ) noexcept
+{
+	if( this != &permutationSet )
+	{
+		Destroy();
+
+		stateArray.swap( permutationSet.stateArray );
+		freeHandleArray.swap( permutationSet.freeHandleArray );
+		blockArray.swap( permutationSet.blockArray );
+		bucketArray.swap( permutationSet.bucketArray );
+		std::swap( handleCount, permutationSet.handleCount );
+		std::swap( count, permutationSet.count );
+		std::swap( bucketMask, permutationSet.bucketMask );
+		std::swap( firstHandle, permutationSet.firstHandle );
+	}
+
+	return *this;
+}
+
+PermutationHashSet::const_iterator PermutationHashSet::begin( void ) const
+{
+	return const_iterator( this, NextHandle( firstHandle ) );
+}
+
+PermutationHashSet::Handle PermutationHashSet::NextHandle( Handle handle ) const
+{
+	if( handle >= handleCount )
+		return nullHandle;
+
+	const uint8_t* state = ( const uint8_t* )memchr( &stateArray[ handle ], SlotLive, handleCount - handle );
+	if( !state )
+		return nullHandle;
+
+	return Handle( state - stateArray.data() );
+}
+
+PermutationHashSet::const_iterator PermutationHashSet::find( const Permutation& permutation ) const
+{
+	if( count == 0 )
+		return end();
+
+	bool found = false;
+	uint i = FindBucket( permutation, MakeTag( permutation.CalcHash() ), found );
+	if( !found )
+		return end();
+
+	return const_iterator( this, bucketArray[i].handle );
+}
+
+std::pair< PermutationHashSet::iterator, bool > PermutationHashSet::insert( const Permutation& permutation )
+{
+	MakeRoomForOne();
+
+	uint tag = MakeTag( permutation.CalcHash() );
+	bool found = false;
+	uint i = FindBucket( permutation, tag, found );
+	if( found )
+		return std::pair< iterator, bool >( iterator( this, bucketArray[i].handle ), false );
+
+	Handle handle = AllocateHandle();
+	new( Slot( handle ) ) Permutation( permutation );
+	return Link( handle, i, tag );
+}
+
+std::pair< PermutationHashSet::iterator, bool > PermutationHashSet::insert( Permutation&& permutation )
+{
+	MakeRoomForOne();
+
+	uint tag = MakeTag( permutation.CalcHash() );
+	bool found = false;
+	uint i = FindBucket( permutation, tag, found );
+	if( found )
+		return std::pair< iterator, bool >( iterator( this, bucketArray[i].handle ), false );
+
+	Handle handle = AllocateHandle();
+	new( Slot( handle ) ) Permutation( std::move( permutation ) );
+	return Link( handle, i, tag );
+}
+
+// The node's permutation may have been changed since it was extracted, so its hash is
+// found again, but it goes back in under the same handle.
+PermutationHashSet::iterator PermutationHashSet::insert( node_type&& node )
+{
+	if( node.empty() )
+		return end();
+
+	Handle handle = node.handle;
+	node.permutationSet = nullptr;
+
+	MakeRoomForOne();
+
+	const Permutation& permutation = *Slot( handle );
+	uint tag = MakeTag( permutation.CalcHash() );
+	bool found = false;
+	uint i = FindBucket( permutation, tag, found );
+	if( found )
+	{
+		ReleaseHandle( handle );
+		return iterator( this, bucketArray[i].handle );
+	}
+
+	return Link( handle, i, tag ).first;
+}
+
+PermutationHashSet::iterator PermutationHashSet::erase( const_iterator iter )
+{
+	Handle handle = iter.handle;
+	Handle nextHandle = NextHandle( handle + 1 );
+
+	Unlink( handle );
+	ReleaseHandle( handle );
+
+	return iterator( this, nextHandle );
+}
+
+PermutationHashSet::node_type PermutationHashSet::extract( const_iterator iter )
+{
+	node_type node;
+	node.permutationSet = this;
+	node.handle = iter.handle;
+
+	Unlink( iter.handle );
+	stateArray[ iter.handle ] = SlotExtracted;
+
+	return node;
+}
+
+// The slab and the buckets are kept for whatever goes into the set next.  A permutation still
+// held by a node is left where it is, with its handle, for the node to put back or destroy.
+void PermutationHashSet::clear( void )
+{
+	Handle newHandleCount = 0;
+
+	for( Handle handle = 0; handle < handleCount; handle++ )
+	{
+		if( stateArray[ handle ] == SlotLive )
+		{
+			Slot( handle )->~Permutation();
+			stateArray[ handle ] = SlotFree;
+		}
+		else if( stateArray[ handle ] == SlotExtracted )
+			newHandleCount = handle + 1;
+	}
+
+	freeHandleArray.clear();
+	for( Handle handle = 0; handle < newHandleCount; handle++ )
+		if( stateArray[ handle ] == SlotFree )
+			freeHandleArray.push_back( handle );
+
+	for( uint i = 0; i < bucketArray.size(); i++ )
+		bucketArray[i].handle = nullHandle;
+
+	handleCount = newHandleCount;
+	count = 0;
+	firstHandle = 0;
+}
+
+void PermutationHashSet::reserve( size_type elementCount )
+{
+	uint newBucketCount = minBucketCount;
+	while( elementCount * 8 > newBucketCount * maxLoadEighths )
+		newBucketCount *= 2;
+
+	if( newBucketCount > bucketArray.size() )
+		Rehash( newBucketCount );
+}
+
+// This is the bucket holding the given permutation if it's in the set, or else the empty
+// bucket where it would go.  There's always at least one empty bucket.
+uint PermutationHashSet::FindBucket( const Permutation& permutation, uint tag, bool& found ) const
+{
+	uint i = tag & bucketMask;
+	while( true )
+	{
+		const Bucket& bucket = bucketArray[i];
+		if( bucket.handle == nullHandle )
+		{
+			found = false;
+			return i;
+		}
+
+		if( bucket.tag == tag && *Slot( bucket.handle ) == permutation )
+		{
+			found = true;
+			return i;
+		}
+
+		i = ( i + 1 ) & bucketMask;
+	}
+}
+
+uint PermutationHashSet::FindBucketOfHandle( Handle handle ) const
+{
+	uint i = MakeTag( Slot( handle )->CalcHash() ) & bucketMask;
+	while( bucketArray[i].handle != handle )
+		i = ( i + 1 ) & bucketMask;
+
+	return i;
+}
+
+// Rather than leave a marker behind, the buckets after an erased one are shifted back into
+// the gap, for as long as that doesn't move any of them ahead of where its probe starts.
+// Lookups then never have to step over the remains of erased permutations.
+void PermutationHashSet::EraseBucket( uint i )
+{
+	uint j = i;
+	while( true )
+	{
+		j = ( j + 1 ) & bucketMask;
+		if( bucketArray[j].handle == nullHandle )
+			break;
+
+		uint home = bucketArray[j].tag & bucketMask;
+		if( ( ( j - home ) & bucketMask ) >= ( ( j - i ) & bucketMask ) )
+		{
+			bucketArray[i] = bucketArray[j];
+			i = j;
+		}
+	}
+
+	bucketArray[i].handle = nullHandle;
+}
+
+// Since every bucket keeps a tag made from its permutation's hash, no permutation has to
+// be looked at to rehash the set.
+void PermutationHashSet::Rehash( uint newBucketCount )
+{
+	std::vector< Bucket > oldBucketArray;
+	oldBucketArray.swap( bucketArray );
+
+	Bucket emptyBucket;
+	emptyBucket.tag = 0;
+	emptyBucket.handle = nullHandle;
+	bucketArray.resize( newBucketCount, emptyBucket );
+	bucketMask = newBucketCount - 1;
+
+	for( uint j = 0; j < oldBucketArray.size(); j++ )
+	{
+		const Bucket& bucket = oldBucketArray[j];
+		if( bucket.handle == nullHandle )
+			continue;
+
+		uint i = bucket.tag & bucketMask;
+		while( bucketArray[i].handle != nullHandle )
+			i = ( i + 1 ) & bucketMask;
+
+		bucketArray[i] = bucket;
+	}
+}
+
+void PermutationHashSet::MakeRoomForOne( void )
+{
+	if( ( count + 1 ) * 8 > bucketArray.size() * maxLoadEighths )
+		Rehash( bucketArray.size() > 0 ? uint( bucketArray.size() * 2 ) : minBucketCount );
+}
+
+// The handles of erased permutations are reused first.  Otherwise, the next handle is
+// given out, and a new block is added to the slab when it's full.
+PermutationHashSet::Handle PermutationHashSet::AllocateHandle( void )
+{
+	if( freeHandleArray.size() > 0 )
+	{
+		Handle handle = freeHandleArray.back();
+		freeHandleArray.pop_back();
+		return handle;
+	}
+
+	if( handleCount == stateArray.size() )
+	{
+		uint blockSize = BlockSize( ( uint )blockArray.size() );
+		blockArray.push_back( std::allocator< Permutation >().allocate( blockSize ) );
+		stateArray.resize( stateArray.size() + blockSize, SlotFree );
+	}
+
+	return handleCount++;
+}
+
+void PermutationHashSet::ReleaseHandle( Handle handle )
+{
+	Slot( handle )->~Permutation();
+	stateArray[ handle ] = SlotFree;
+	freeHandleArray.push_back( handle );
+}
+
+std::pair< PermutationHashSet::iterator, bool > PermutationHashSet::Link( Handle handle, uint i, uint tag )
+{
+	bucketArray[i].tag = tag;
+	bucketArray[i].handle = handle;
+	stateArray[ handle ] = SlotLive;
+	count++;
+
+	if( handle < firstHandle )
+		firstHandle = handle;
+
+	return std::pair< iterator, bool >( iterator( this, handle ), true );
+}
+
+void PermutationHashSet::Unlink( Handle handle )
+{
+	EraseBucket( FindBucketOfHandle( handle ) );
+	stateArray[ handle ] = SlotFree;
+	count--;
+
+	if( handle == firstHandle )
+	{
+		firstHandle = NextHandle( handle + 1 );
+		if( firstHandle == nullHandle )
+			firstHandle = handleCount;
+	}
+}
+
+// Nodes can't outlive the set, so any permutation still held by one is destroyed here.
+void PermutationHashSet::Destroy( void )
+{
+	clear();
+
+	for( Handle handle = 0; handle < handleCount; handle++ )
+		if( stateArray[ handle ] == SlotExtracted )
+			Slot( handle )->~Permutation();
+
+	freeHandleArray.clear();
+	handleCount = 0;
+
+	for( uint i = 0; i < blockArray.size(); i++ )
+		std::allocator< Permutation >().deallocate( blockArray[i], BlockSize(i) );
+
+	stateArray.clear();
+	blockArray.clear();
+	bucketArray.clear();
+	bucketMask = 0;
+}
+
+/*static*/ uint PermutationHashSet::BlockSize( uint blockIndex )
+{
+	uint blockSize = minBlockSize;
+	while( blockIndex-- > 0 && blockSize < maxBlockSize )
+		blockSize *= 2;
+
+	return blockSize;
+}
+
+//------------------------------------------------------------------------------------------
+//                               PermutationHashSet::node_type
+//------------------------------------------------------------------------------------------
+
+PermutationHashSet::node_type::node_type( node_type&& node ) noexcept
+{
+	permutationSet = node.permutationSet;
+	handle = node.handle;
+	node.permutationSet = nullptr;
+}
+
+PermutationHashSet::node_type::~node_type( void )
+{
+	if( permutationSet )
+		permutationSet->ReleaseHandle( handle );
+}
+
+PermutationHashSet::node_type& PermutationHashSet::node_type::operator=( node_type&& node ) noexcept
+{
+	if( this != &node )
+	{
+		if( permutationSet )
+			permutationSet->ReleaseHandle( handle );
+
+		permutationSet = node.permutationSet;
+		handle = node.handle;
+		node.permutationSet = nullptr;
+	}
+
+	return *this;
+}
+
+// PermutationHashSet.cpp
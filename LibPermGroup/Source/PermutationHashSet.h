@@ -0,0 +1,209 @@
+// PermutationHashSet.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <bit>
+
+//------------------------------------------------------------------------------------------
+//                                   PermutationHashSet
+//------------------------------------------------------------------------------------------
+
+// This is the set behind PermutationSet.  It has the same interface as the standard
+// unordered set it replaces, but it's laid out for the way stabilizer chains use it.
+// The permutations themselves are kept in a slab of blocks that are never moved, and each
+// is known by a handle, its index in the slab, which stays the same for as long as it's in
+// the set.  The hash table is then just an array of buckets, each holding the handle of a
+// permutation along with a tag made from its hash, and is searched by linear probing, so
+// that a lookup reads adjacent buckets and only compares permutations whose tags match.
+//
+// Iteration goes through the slab in order of handle, which is the order in which the
+// permutations were added, other than where the handle of an erased one has been reused.
+// Erasing a permutation, or inserting one, never invalidates iterators to the others.
+class PermutationHashSet
+{
+public:
+
+	typedef uint Handle;
+	typedef Permutation value_type;
+	typedef std::size_t size_type;
+
+	static const Handle nullHandle = 0xFFFFFFFF;
+
+	PermutationHashSet( void );
+	PermutationHashSet( const PermutationHashSet& permutationSet );
+	PermutationHashSet( PermutationHashSet&& permutationSet ) noexcept;
+	~PermutationHashSet( void );
+
+	PermutationHashSet& operator=( const PermutationHashSet& permutationSet );
+	PermutationHashSet& operator=( PermutationHashSet&& permutationSet ) noexcept;
+
+	// As with the standard set, permutations can't be changed while they're in the set, so
+	// there's only the one kind of iterator.  It's just the handle of the permutation.
+	class const_iterator
+	{
+	public:
+
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Permutation value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const Permutation* pointer;
+		typedef const Permutation& reference;
+
+		const_iterator( void ) : permutationSet( nullptr ), handle( nullHandle ) {}
+		const_iterator( const PermutationHashSet* permutationSet, Handle handle ) : permutationSet( permutationSet ), handle( handle ) {}
+
+		const Permutation& operator*( void ) const { return permutationSet->Get( handle ); }
+		const Permutation* operator->( void ) const { return &permutationSet->Get( handle ); }
+
+		const_iterator& operator++( void )
+		{
+			handle = permutationSet->NextHandle( handle + 1 );
+			return *this;
+		}
+
+		const_iterator operator++( int )
+		{
+			const_iterator iter = *this;
+			handle = permutationSet->NextHandle( handle + 1 );
+			return iter;
+		}
+
+		bool operator==( const const_iterator& iter ) const { return handle == iter.handle; }
+		bool operator!=( const const_iterator& iter ) const { return handle != iter.handle; }
+
+		const PermutationHashSet* permutationSet;
+		Handle handle;
+	};
+
+	typedef const_iterator iterator;
+
+	// A permutation taken out of the set with extract stays where it is in the slab, with its
+	// handle, but is no longer found by lookups or iteration.  It can then be changed through
+	// the node and put back, keeping its handle, or else it's destroyed along with the node.
+	// Unlike the standard set, a node must not outlive the set it came from, nor be held while
+	// that set is moved or assigned to.  Clearing the set leaves it alone, though.
+	class node_type
+	{
+	public:
+
+		node_type( void ) : permutationSet( nullptr ), handle( nullHandle ) {}
+		node_type( node_type&& node ) noexcept;
+		~node_type( void );
+
+		node_type& operator=( node_type&& node ) noexcept;
+
+		bool empty( void ) const { return permutationSet == nullptr; }
+		Permutation& value( void ) const { return *permutationSet->Slot( handle ); }
+
+		PermutationHashSet* permutationSet;
+		Handle handle;
+	};
+
+	const_iterator begin( void ) const;
+	const_iterator end( void ) const { return const_iterator( this, nullHandle ); }
+	const_iterator cbegin( void ) const { return begin(); }
+	const_iterator cend( void ) const { return end(); }
+
+	size_type size( void ) const { return count; }
+	bool empty( void ) const { return count == 0; }
+
+	const_iterator find( const Permutation& permutation ) const;
+	std::pair< iterator, bool > insert( const Permutation& permutation );
+	std::pair< iterator, bool > insert( Permutation&& permutation );
+
+	// When the node's permutation is already in the set, the node's copy is destroyed.
+	iterator insert( node_type&& node );
+
+	template< typename... Arguments >
+	std::pair< iterator, bool > emplace( Arguments&&... arguments )
+	{
+		return insert( Permutation( std::forward< Arguments >( arguments )... ) );
+	}
+
+	iterator erase( const_iterator iter );
+	node_type extract( const_iterator iter );
+	void clear( void );
+	void reserve( size_type elementCount );
+
+	// Handles can be held instead of pointers or iterators.  The permutation of a given
+	// handle must be in the set.
+	const Permutation& Get( Handle handle ) const { return *Slot( handle ); }
+
+	// This is the first handle, from the given one onward, of a permutation in the set.
+	Handle NextHandle( Handle handle ) const;
+
+private:
+
+	enum SlotState : uint8_t
+	{
+		SlotFree,
+		SlotLive,
+		SlotExtracted
+	};
+
+	// A bucket holds the handle of a permutation, or the null handle if it's empty.
+	struct Bucket
+	{
+		uint tag;
+		Handle handle;
+	};
+
+	// Buckets are at most this many eighths full.
+	static const uint maxLoadEighths = 6;
+	static const uint minBucketCount = 8;
+
+	// The slab grows by blocks of these many permutations, doubling from the smallest.  Every
+	// handle from the first of the largest blocks onward is then in a block of the largest size.
+	static const uint minBlockSize = 4;
+	static const uint maxBlockSize = 256;
+	static const uint doublingBlockCount = 7;
+	static const Handle firstFullBlockHandle = 2 * maxBlockSize - minBlockSize;
+
+	static uint MakeTag( std::size_t hash ) { return uint( hash ^ ( ( uint64_t )hash >> 32 ) ); }
+
+	uint FindBucket( const Permutation& permutation, uint tag, bool& found ) const;
+	uint FindBucketOfHandle( Handle handle ) const;
+	void EraseBucket( uint i );
+	void Rehash( uint newBucketCount );
+	void MakeRoomForOne( void );
+	Handle AllocateHandle( void );
+	void ReleaseHandle( Handle handle );
+	std::pair< iterator, bool > Link( Handle handle, uint i, uint tag );
+	void Unlink( Handle handle );
+	void Destroy( void );
+
+	static uint BlockSize( uint blockIndex );
+
+	// The storage of a handle is found from the sizes of the blocks, rather than kept for each
+	// handle, which saves a pointer per permutation and a load on every lookup.
+	Permutation* Slot( Handle handle ) const
+	{
+		if( handle < firstFullBlockHandle )
+		{
+			uint blockIndex = std::bit_width( handle / minBlockSize + 1 ) - 1;
+			return blockArray[ blockIndex ] + ( handle - minBlockSize * ( ( 1 << blockIndex ) - 1 ) );
+		}
+
+		handle -= firstFullBlockHandle;
+		return blockArray[ doublingBlockCount + handle / maxBlockSize ] + handle % maxBlockSize;
+	}
+
+	// The blocks are only freed by Destroy.  The state array covers every handle they hold.
+	std::vector< uint8_t > stateArray;
+	std::vector< Handle > freeHandleArray;
+	std::vector< Permutation* > blockArray;
+	std::vector< Bucket > bucketArray;
+	Handle handleCount;
+	uint count;
+	uint bucketMask;
+
+	// No handle below this is live, which keeps begin quick when the set is used as a queue.
+	Handle firstHandle;
+};
+
+// PermutationHashSet.h
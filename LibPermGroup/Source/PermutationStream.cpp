@@ -1,6 +1,7 @@
 // PermutationStream.cpp
 
 #include "PermutationStream.h"
+#include <algorithm>
 
 //------------------------------------------------------------------------------------------
 //                                 PermutationStream
@@ -104,7 +105,10 @@ PermutationProductStream::PermutationProductStream( void )
 void PermutationProductStream::Clear( void )
 {
 	for( uint i = 0; i < componentArray.size(); i++ )
+	{
 		delete componentArray[i].permutationArray;
+		delete componentArray[i].programArray;
+	}
 	componentArray.clear();
 }
 
@@ -117,11 +121,35 @@ void PermutationProductStream::Clear( void )
 
 /*virtual*/ bool PermutationProductStream::OutputPermutation( Permutation& permutation )
 {
+	// The maps are multiplied without words, and the word of the whole product is then made
+	// as a single program node over the words of its factors.
 	permutation.DefineIdentity();
-	permutation.word = std::make_unique<ElementList>();
+	permutation.word.reset();
+	permutation.wordProgram.reset();
+
+	WordProgram::FactorArray factorArray;
+	bool worded = true;
+
 	uint i;
 	for( i = 0; i < componentArray.size(); i++ )
-		permutation.MultiplyOnRight( *( *componentArray[i].permutationArray )[ componentArray[i].offset ] );
+	{
+		Component* component = &componentArray[i];
+		permutation.MultiplyOnRight( *( *component->permutationArray )[ component->offset ] );
+
+		if( !component->programArray )
+			MakeProgramArray( component );
+
+		WordProgram::Factor factor;
+		factor.program = ( *component->programArray )[ component->offset ];
+		factor.inverse = false;
+		if( !factor.program )
+			worded = false;
+		else if( worded )
+			factorArray.push_back( factor );
+	}
+
+	if( worded )
+		permutation.wordProgram = WordProgram::MakeProduct( factorArray );
 
 	wrapped = false;
 	for( i = 0; i < componentArray.size(); i++ )
@@ -139,6 +167,26 @@ void PermutationProductStream::Clear( void )
 	return true;
 }
 
+// The word of each permutation of a component is made into a program just once, so
+// that the products it is a factor of can all share it.
+void PermutationProductStream::MakeProgramArray( Component* component )
+{
+	component->programArray = new WordProgramArray;
+
+	for( uint i = 0; i < component->permutationArray->size(); i++ )
+	{
+		const Permutation* permutation = ( *component->permutationArray )[i];
+
+		WordProgramPtr program = permutation->wordProgram;
+		if( !program && permutation->word )
+			program = WordProgram::MakeLeaf( *permutation->word );
+
+		component->programArray->push_back( program );
+	}
+}
+
+// The chain's transversal sets are walked as they are, so any Schreier vectors in it should
+// have been materialized first.
 void PermutationProductStream::Configure( const StabilizerChain* stabChain )
 {
 	Clear();
@@ -152,6 +200,7 @@ void PermutationProductStream::Configure( const StabilizerChain* stabChain )
 		Component component;
 		component.offset = 0;
 		component.permutationArray = new PermutationConstPtrArray;
+		component.programArray = nullptr;
 
 		for( PermutationSet::const_iterator iter = subGroup->transversalSet.cbegin(); iter != subGroup->transversalSet.cend(); iter++ )
 			component.permutationArray->push_back( &( *iter ) );
@@ -214,6 +263,7 @@ PermutationFreeGroupStream::PermutationFreeGroupStream( const PermutationSet* ge
 				PermutationProductStream::Component component;
 				component.offset = 0;
 				component.permutationArray = new PermutationConstPtrArray;
+				component.programArray = nullptr;
 
 				for( uint j = 0; j < generatorArray.size(); j++ )
 					component.permutationArray->push_back( &generatorArray[j] );
@@ -255,7 +305,7 @@ PermutationFifoStream::PermutationFifoStream( void )
 	if( permutationList.size() == 0 )
 		return false;
 
-	permutation = permutationList.back();
+	permutation = std::move( permutationList.back() );
 	permutationList.pop_back();
 	return true;
 }
@@ -266,6 +316,77 @@ PermutationFifoStream::PermutationFifoStream( void )
 	return true;
 }
 
+//------------------------------------------------------------------------------------------
+//                                 PermutationByteStream
+//------------------------------------------------------------------------------------------
+
+PermutationByteStream::PermutationByteStream( void ) : encoder( byteString ), decoder( byteString )
+{
+}
+
+/*virtual*/ PermutationByteStream::~PermutationByteStream( void )
+{
+}
+
+/*virtual*/ bool PermutationByteStream::Reset( void )
+{
+	decoder.Reset();
+	return true;
+}
+
+/*virtual*/ bool PermutationByteStream::OutputPermutation( Permutation& permutation )
+{
+	if( decoder.AtEnd() )
+		return false;
+
+	return decoder.DecodePermutation( permutation );
+}
+
+/*virtual*/ bool PermutationByteStream::InputPermutation( const Permutation& permutation )
+{
+	encoder.EncodePermutation( permutation );
+	return true;
+}
+
+// The bytes are read through once, so that the encoder knows which generator names they
+// already hold, and carries on numbering them from there.
+bool PermutationByteStream::SetByteString( const std::string& byteString )
+{
+	Clear();
+	this->byteString = byteString;
+
+	Permutation permutation;
+	while( !decoder.AtEnd() )
+	{
+		if( !decoder.DecodePermutation( permutation ) )
+		{
+			Clear();
+			return false;
+		}
+	}
+
+	for( uint i = 0; i < decoder.idArray.size(); i++ )
+	{
+		uint id = decoder.idArray[i];
+		if( id >= encoder.localIdArray.size() )
+			encoder.localIdArray.resize( id + 1, 0 );
+
+		encoder.localIdArray[ id ] = i + 1;
+	}
+
+	encoder.localIdCount = ( uint )decoder.idArray.size();
+	decoder.Reset();
+	return true;
+}
+
+void PermutationByteStream::Clear( void )
+{
+	byteString.clear();
+	encoder.localIdArray.clear();
+	encoder.localIdCount = 0;
+	decoder.Reset();
+}
+
 //------------------------------------------------------------------------------------------
 //                               PermutationWordStream
 //------------------------------------------------------------------------------------------
@@ -285,45 +406,78 @@ PermutationWordStream::PermutationWordStream( const PermutationSet* generatorSet
 {
 }
 
+// The heap has the least word on top, where the standard heap functions put the greatest.
+struct WordQueueOrder
+{
+	const PermutationSet* permutationQueue;
+
+	bool operator()( PermutationSet::Handle handleA, PermutationSet::Handle handleB ) const
+	{
+		return Permutation::LexigraphicCompare( permutationQueue->Get( handleB ), permutationQueue->Get( handleA ) );
+	}
+};
+
 /*virtual*/ bool PermutationWordStream::Reset( void )
 {
 	processedSet.clear();
 	permutationQueue.clear();
+	queueHeap.clear();
+
+	// Every queued permutation is multiplied by all of the generators, which a batch does at once.
+	generatorArray.clear();
+	generatorBatch.SetDegree( PermutationBatch::Degree( *generatorSet ) );
+	for( PermutationSet::const_iterator genIter = generatorSet->cbegin(); genIter != generatorSet->cend(); genIter++ )
+	{
+		generatorArray.push_back( &( *genIter ) );
+		generatorBatch.Add( *genIter );
+	}
 
 	Permutation identity;
-	identity.word = std::make_unique<ElementList>();
-	permutationQueue.insert( identity );
+	identity.word = std::make_unique<ElementArray>();
+	queueHeap.push_back( permutationQueue.insert( identity ).first.handle );
 
 	return true;
 }
 
 /*virtual*/ bool PermutationWordStream::OutputPermutation( Permutation& permutation )
 {
-	if( permutationQueue.size() == 0 )
+	if( queueHeap.size() == 0 )
 		return false;
 
-	OrderedPermutationSet::iterator iter = permutationQueue.begin();
-	permutation = *iter;
-	permutationQueue.erase( iter );
+	WordQueueOrder queueOrder;
+	queueOrder.permutationQueue = &permutationQueue;
+
+	std::pop_heap( queueHeap.begin(), queueHeap.end(), queueOrder );
+	PermutationSet::const_iterator queueIter( &permutationQueue, queueHeap.back() );
+	queueHeap.pop_back();
+
+	permutation = std::move( permutationQueue.extract( queueIter ).value() );
 
 	// If the queue max was reached, just drain what remains in the queue.
 	if( !queueMaxReached )
 	{
 		processedSet.insert( permutation );
 
-		for( PermutationSet::const_iterator genIter = generatorSet->cbegin(); genIter != generatorSet->cend(); genIter++ )
-		{
-			const Permutation& generator = *genIter;
+		if( !productBatch.ComposeWithOne( generatorBatch, permutation, false ) )
+			return false;
 
-			Permutation newPermutation;
-			newPermutation.Multiply( permutation, generator );
+		Permutation newPermutation;
+
+		for( uint i = 0; i < generatorArray.size(); i++ )
+		{
+			productBatch.Get( i, newPermutation );
+			Permutation::MultiplyWords( newPermutation, { { &permutation, false }, { generatorArray[i], false } } );
 
 			newPermutation.CompressWord( *compressInfo );
 
-			if( processedSet.find( newPermutation ) == processedSet.end() &&
-				permutationQueue.find( newPermutation ) == permutationQueue.end() )
+			if( processedSet.find( newPermutation ) == processedSet.end() )
 			{
-				permutationQueue.insert( newPermutation );
+				std::pair< PermutationSet::iterator, bool > result = permutationQueue.insert( std::move( newPermutation ) );
+				if( result.second )
+				{
+					queueHeap.push_back( result.first.handle );
+					std::push_heap( queueHeap.begin(), queueHeap.end(), queueOrder );
+				}
 			}
 		}
 
@@ -372,8 +526,7 @@ PermutationRandomStream::PermutationRandomStream( const PermutationSet* generato
 	Permutation invConjugator;
 	conjugator.GetInverse( invConjugator );
 
-	permutation.Multiply( conjugator, randomCommutator );
-	permutation.MultiplyOnRight( invConjugator );
+	permutation.Conjugate( randomCommutator, invConjugator );
 
 	currentConjugateCount++;
 	return true;
@@ -416,20 +569,82 @@ void PermutationRandomStream::GenerateRandomCommutator( Permutation& commutator,
 			else
 				GenerateRandomCommutator( permutationB, 0 );
 
-			Permutation invPermutationA, invPermutationB;
+			Commutator( permutationA, permutationB ).GetPermutation( commutator );
+		}
+		while( commutator.IsIdentity() );
+	}
+}
 
-			permutationA.GetInverse( invPermutationA );
-			permutationB.GetInverse( invPermutationB );
+//------------------------------------------------------------------------------------------
+//                          PermutationProductReplacementStream
+//------------------------------------------------------------------------------------------
 
-			Permutation productA, productB;
+PermutationProductReplacementStream::PermutationProductReplacementStream( const PermutationSet* generatorSet, uint seed /*= 0*/ )
+{
+	this->generatorSet = generatorSet;
+	this->seed = seed;
+	slotCount = 10;
+	warmUpCount = 50;
 
-			productA.Multiply( permutationA, permutationB );
-			productB.Multiply( invPermutationA, invPermutationB );
+	Reset();
+}
 
-			commutator.Multiply( productA, productB );
-		}
-		while( commutator.IsIdentity() );
+/*virtual*/ PermutationProductReplacementStream::~PermutationProductReplacementStream( void )
+{
+}
+
+// There are always at least two slots, and if there are more slots than generators, the
+// generators are repeated to fill them.
+/*virtual*/ bool PermutationProductReplacementStream::Reset( void )
+{
+	random.seed( seed );
+
+	uint count = std::max( slotCount, std::max( ( uint )generatorSet->size(), 2u ) );
+	slotArray.resize( count );
+
+	PermutationSet::const_iterator iter = generatorSet->cbegin();
+	for( uint i = 0; i < count; i++ )
+	{
+		if( iter == generatorSet->cend() )
+			iter = generatorSet->cbegin();
+
+		if( iter == generatorSet->cend() )
+			slotArray[i].DefineIdentity();
+		else
+			slotArray[i].SetCopy( *iter++, false );
 	}
+
+	accumulator.DefineIdentity();
+
+	for( uint i = 0; i < warmUpCount; i++ )
+		Step();
+
+	return true;
+}
+
+/*virtual*/ bool PermutationProductReplacementStream::OutputPermutation( Permutation& permutation )
+{
+	Step();
+
+	permutation.SetCopy( accumulator, false );
+	return true;
+}
+
+void PermutationProductReplacementStream::Step( void )
+{
+	uint count = ( uint )slotArray.size();
+
+	uint i = random() % count;
+	uint j = random() % ( count - 1 );
+	if( j >= i )
+		j++;
+
+	if( random() & 1 )
+		slotArray[i].MultiplyOnRight( slotArray[j] );
+	else
+		slotArray[i].MultiplyInverse( slotArray[i], slotArray[j] );
+
+	accumulator.MultiplyOnRight( slotArray[i] );
 }
 
 //------------------------------------------------------------------------------------------
@@ -452,10 +667,11 @@ PermutationOrbitStream::PermutationOrbitStream( const PermutationSet* generatorS
 /*virtual*/ bool PermutationOrbitStream::Reset( void )
 {
 	orbitSet.RemoveAllMembers();
+	orbitSet.Reserve( PermutationBatch::Degree( *generatorSet ) );
 	permutationQueue.clear();
 
 	Permutation identity;
-	identity.word = std::make_unique<ElementList>();
+	identity.word = std::make_unique<ElementArray>();
 	permutationQueue.insert( identity );
 
 	return true;
@@ -466,25 +682,24 @@ PermutationOrbitStream::PermutationOrbitStream( const PermutationSet* generatorS
 	if( permutationQueue.size() == 0 )
 		return false;
 
-	PermutationSet::iterator iter = permutationQueue.begin();
-	permutation = *iter;
-	permutationQueue.erase( iter );
+	permutation = std::move( permutationQueue.extract( permutationQueue.begin() ).value() );
 
 	uint point = permutation.Evaluate( stabilizerPoint );
 	orbitSet.AddMember( point );
 
+	Permutation newPermutation;
+
 	for( PermutationSet::const_iterator genIter = generatorSet->cbegin(); genIter != generatorSet->cend(); genIter++ )
 	{
 		const Permutation& generator = *genIter;
 
-		Permutation newPermutation;
 		newPermutation.Multiply( permutation, generator );
 
 		point = newPermutation.Evaluate( stabilizerPoint );
 		if( !orbitSet.IsMember( point ) && permutationQueue.find( newPermutation ) == permutationQueue.end() )
 		{
 			newPermutation.CompressWord( *compressInfo );
-			permutationQueue.insert( newPermutation );
+			permutationQueue.insert( std::move( newPermutation ) );
 		}
 	}
 
@@ -521,7 +736,7 @@ PermutationStabChainStream::PermutationStabChainStream( const StabilizerChain* s
 		for( PermutationSet::const_iterator iter = group->transversalSet.cbegin(); iter != group->transversalSet.cend(); iter++ )
 		{
 			const Permutation& cosetRepresentative = *iter;
-			if( cosetRepresentative.word && cosetRepresentative.word->size() > 0 )
+			if( cosetRepresentative.HasWord() && cosetRepresentative.WordLength() > 0 )
 				permutationArray.push_back( &cosetRepresentative );
 		}
 
@@ -3,6 +3,9 @@
 #pragma once
 
 #include "StabilizerChain.h"
+#include "PermutationBatch.h"
+#include "PermutationCodec.h"
+#include <random>
 
 //------------------------------------------------------------------------------------------
 //                                 PermutationStream
@@ -71,8 +74,11 @@ public:
 	{
 		uint offset;
 		PermutationConstPtrArray* permutationArray;
+		WordProgramArray* programArray;
 	};
 
+	void MakeProgramArray( Component* component );
+
 	typedef std::vector< Component > ComponentArray;
 	ComponentArray componentArray;
 	bool wrapped;
@@ -95,6 +101,38 @@ public:
 	PermutationList permutationList;
 };
 
+//------------------------------------------------------------------------------------------
+//                                 PermutationByteStream
+//------------------------------------------------------------------------------------------
+
+// This is a first-in, first-out stream that keeps its permutations in the compact binary form,
+// which takes a fraction of the memory of the permutations themselves.  Nothing is removed as
+// it's read, so resetting the stream replays it from the start.  The bytes can be saved, and
+// given back to a stream later to pick up where it left off.
+class PermutationByteStream : public PermutationStream
+{
+public:
+
+	PermutationByteStream( void );
+	virtual ~PermutationByteStream( void );
+
+	virtual bool Reset( void ) override;
+	virtual bool OutputPermutation( Permutation& permutation ) override;
+	virtual bool InputPermutation( const Permutation& permutation ) override;
+
+	// This fails, leaving the stream empty, if the bytes aren't a whole number of permutations.
+	bool SetByteString( const std::string& byteString );
+	const std::string& GetByteString( void ) const { return byteString; }
+
+	void Clear( void );
+
+private:
+
+	std::string byteString;
+	PermutationEncoder encoder;
+	PermutationDecoder decoder;
+};
+
 //------------------------------------------------------------------------------------------
 //                              PermutationFreeGroupStream
 //------------------------------------------------------------------------------------------
@@ -121,6 +159,9 @@ public:
 //                               PermutationWordStream
 //------------------------------------------------------------------------------------------
 
+// Permutations come out of this in order of their words, shortest first.  The queue is kept
+// in a permutation set, so each permutation is queued just once, under the first word found
+// for it, and the order is kept by a heap of the handles of the queued permutations.
 class PermutationWordStream : public PermutationStream
 {
 public:
@@ -134,9 +175,13 @@ public:
 	const PermutationSet* generatorSet;
 	const CompressInfo* compressInfo;
 	PermutationSet processedSet;
-	OrderedPermutationSet permutationQueue;
+	PermutationSet permutationQueue;
+	std::vector< PermutationSet::Handle > queueHeap;
 	uint queueMax;
 	bool queueMaxReached;
+	PermutationConstPtrArray generatorArray;
+	PermutationBatch generatorBatch;
+	PermutationBatch productBatch;
 };
 
 //------------------------------------------------------------------------------------------
@@ -165,6 +210,39 @@ public:
 	PermutationFreeGroupStream nonCommutatorStream;
 };
 
+//------------------------------------------------------------------------------------------
+//                          PermutationProductReplacementStream
+//------------------------------------------------------------------------------------------
+
+// This puts out close to uniformly random elements of the group generated by the given set,
+// using the product replacement algorithm.  A handful of slots start out as the generators,
+// and at each step one slot is multiplied by another, or by its inverse, and an accumulator
+// by the result.  Some steps are taken before anything is put out, so that the first few
+// elements aren't just short products of the generators.  The elements have no words.  The
+// same seed always gives the same elements, and resetting the stream starts them over.
+class PermutationProductReplacementStream : public PermutationStream
+{
+public:
+
+	PermutationProductReplacementStream( const PermutationSet* generatorSet, uint seed = 0 );
+	virtual ~PermutationProductReplacementStream( void );
+
+	virtual bool Reset( void ) override;
+	virtual bool OutputPermutation( Permutation& permutation ) override;
+
+	const PermutationSet* generatorSet;
+	uint seed;
+	uint slotCount;
+	uint warmUpCount;
+	PermutationArray slotArray;
+	Permutation accumulator;
+	std::mt19937 random;
+
+private:
+
+	void Step( void );
+};
+
 //------------------------------------------------------------------------------------------
 //                                    PermutationOrbitStream
 //------------------------------------------------------------------------------------------
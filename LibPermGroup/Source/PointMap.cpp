@@ -0,0 +1,336 @@
+// PointMap.cpp
+
+#include "PointMap.h"
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------------------
+//                                        PointMap
+//------------------------------------------------------------------------------------------
+
+static constexpr struct IdentityTable
+{
+	constexpr IdentityTable( void ) : bytes()
+	{
+		for( uint i = 0; i < PointMap::inlineCapacity; i++ )
+			bytes[i] = ( uint8_t )i;
+	}
+
+	uint8_t bytes[ PointMap::inlineCapacity ];
+} identityTable;
+
+// A map of size zero holds nothing but the identity, so when it lets go of heap storage,
+// the storage is kept here rather than freed.  A map growing to that capacity again can
+// then take it without having to fill it in.  Only a few are kept for each thread.
+static thread_local struct IdentityPool
+{
+	struct Entry
+	{
+		uint8_t* data;
+		uint capacity;
+	};
+
+	static const uint maxCount = 4;
+
+	IdentityPool( void ) : count(0) {}
+
+	~IdentityPool( void )
+	{
+		for( uint i = 0; i < count; i++ )
+			delete[] entryArray[i].data;
+	}
+
+	uint8_t* Take( uint capacity )
+	{
+		for( uint i = 0; i < count; i++ )
+		{
+			if( entryArray[i].capacity == capacity )
+			{
+				uint8_t* data = entryArray[i].data;
+				entryArray[i] = entryArray[ --count ];
+				return data;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void Give( uint8_t* data, uint capacity )
+	{
+		if( count == maxCount )
+			delete[] data;
+		else
+		{
+			entryArray[ count ].data = data;
+			entryArray[ count ].capacity = capacity;
+			count++;
+		}
+	}
+
+	Entry entryArray[ maxCount ];
+	uint count;
+} identityPool;
+
+PointMap::PointMap( void )
+{
+	data = inlineBuffer;
+	size = 0;
+	capacity = inlineCapacity;
+	width = 1;
+	memcpy( inlineBuffer, identityTable.bytes, inlineCapacity );
+}
+
+PointMap::PointMap( const PointMap& pointMap ) : PointMap()
+{
+	*this = pointMap;
+}
+
+PointMap::PointMap( PointMap&& pointMap ) noexcept : PointMap()
+{
+	*this = std::move( pointMap );
+}
+
+PointMap::~PointMap( void )
+{
+	if( !IsInline() )
+		delete[] data;
+}
+
+PointMap& PointMap::operator=( const PointMap& pointMap )
+{
+	if( this == &pointMap )
+		return *this;
+
+	if( pointMap.IsInline() )
+	{
+		if( !IsInline() )
+		{
+			Free();
+			data = inlineBuffer;
+			capacity = inlineCapacity;
+			width = 1;
+		}
+
+		// Copying the whole buffer also restores the identity tail past the new size.
+		memcpy( inlineBuffer, pointMap.inlineBuffer, inlineCapacity );
+		size = pointMap.size;
+		return *this;
+	}
+
+	if( capacity != pointMap.capacity )
+	{
+		Free();
+		data = Allocate( pointMap.capacity, pointMap.width );
+		capacity = pointMap.capacity;
+		width = pointMap.width;
+	}
+
+	memcpy( data, pointMap.data, capacity * width );
+	size = pointMap.size;
+	return *this;
+}
+
+PointMap& PointMap::operator=( PointMap&& pointMap ) noexcept
+{
+	if( this == &pointMap )
+		return *this;
+
+	if( pointMap.IsInline() )
+	{
+		*this = pointMap;
+		pointMap.Clear();
+		return *this;
+	}
+
+	Free();
+
+	data = pointMap.data;
+	size = pointMap.size;
+	capacity = pointMap.capacity;
+	width = pointMap.width;
+
+	// The inline buffer may have been left stale when the map first outgrew it.
+	pointMap.data = pointMap.inlineBuffer;
+	pointMap.size = 0;
+	pointMap.capacity = inlineCapacity;
+	pointMap.width = 1;
+	memcpy( pointMap.inlineBuffer, identityTable.bytes, inlineCapacity );
+	return *this;
+}
+
+/*static*/ uint8_t* PointMap::Allocate( uint capacity, uint width )
+{
+	return new uint8_t[ std::size_t( capacity ) * width + gatherSlack ];
+}
+
+void PointMap::Free( void )
+{
+	if( IsInline() )
+		return;
+
+	if( size == 0 )
+		identityPool.Give( data, capacity );
+	else
+		delete[] data;
+}
+
+/*static*/ uint PointMap::CapacityForDegree( uint degree )
+{
+	if( degree > maxDegree )
+		throw std::length_error( "PointMap degree exceeds the maximum." );
+
+	uint capacity = inlineCapacity;
+	while( capacity < degree )
+		capacity <<= 1;
+	return capacity;
+}
+
+/*static*/ uint PointMap::WidthForCapacity( uint capacity )
+{
+	if( capacity <= 0x100 )
+		return 1;
+	if( capacity <= 0x10000 )
+		return 2;
+	return 4;
+}
+
+void PointMap::FillIdentity( uint begin, uint end )
+{
+	if( width == 1 && end <= inlineCapacity )
+	{
+		if( begin < end )
+			memcpy( data + begin, identityTable.bytes + begin, end - begin );
+		return;
+	}
+
+	for( uint i = begin; i < end; i++ )
+		Set( i, i );
+}
+
+// The identity is kept at the narrowest width like any other trimmed map.
+void PointMap::Clear( void )
+{
+	if( width > 1 )
+	{
+		Free();
+		data = inlineBuffer;
+		size = 0;
+		capacity = inlineCapacity;
+		width = 1;
+		memcpy( inlineBuffer, identityTable.bytes, inlineCapacity );
+		return;
+	}
+
+	FillIdentity( 0, size );
+	size = 0;
+}
+
+void PointMap::Resize( uint newSize )
+{
+	if( newSize > capacity )
+		Reserve( newSize );
+	else if( newSize < size )
+		FillIdentity( newSize, size );
+
+	size = newSize;
+}
+
+void PointMap::Reserve( uint degree )
+{
+	if( degree <= capacity )
+		return;
+
+	Reallocate( CapacityForDegree( degree ) );
+}
+
+void PointMap::Reallocate( uint newCapacity )
+{
+	uint newWidth = WidthForCapacity( newCapacity );
+	uint8_t* newData = inlineBuffer;
+	bool newIdentity = false;
+	if( std::size_t( newCapacity ) * newWidth > inlineCapacity )
+	{
+		newData = identityPool.Take( newCapacity );
+		newIdentity = ( newData != nullptr );
+		if( !newIdentity )
+			newData = Allocate( newCapacity, newWidth );
+	}
+
+	uint count = std::min( size, newCapacity );
+	for( uint i = 0; i < count; i++ )
+	{
+		uint x = Get(i);
+		switch( newWidth )
+		{
+			case 1: newData[i] = ( uint8_t )x; break;
+			case 2: ( ( uint16_t* )newData )[i] = ( uint16_t )x; break;
+			default: ( ( uint32_t* )newData )[i] = x; break;
+		}
+	}
+
+	Free();
+
+	data = newData;
+	capacity = newCapacity;
+	width = newWidth;
+	if( !newIdentity )
+		FillIdentity( count, capacity );
+}
+
+void PointMap::Prepare( uint newCapacity, uint overwriteCount )
+{
+	if( newCapacity != capacity )
+	{
+		Free();
+
+		capacity = newCapacity;
+		width = WidthForCapacity( newCapacity );
+		data = inlineBuffer;
+		if( std::size_t( capacity ) * width > inlineCapacity )
+		{
+			data = identityPool.Take( capacity );
+			if( !data )
+			{
+				data = Allocate( capacity, width );
+				FillIdentity( overwriteCount, capacity );
+			}
+		}
+		else
+			FillIdentity( overwriteCount, capacity );
+	}
+	else if( size > overwriteCount )
+		FillIdentity( overwriteCount, size );
+
+	size = 0;
+}
+
+// Trailing fixed points carry no information, so dropping them gives every permutation
+// a canonical form.  Two maps are then equal exactly when their sizes and bytes agree.
+void PointMap::Trim( void )
+{
+	while( size > 0 && Get( size - 1 ) == size - 1 )
+		size--;
+
+	if( width == 1 )
+		return;
+
+	uint newCapacity = CapacityForDegree( size );
+	if( WidthForCapacity( newCapacity ) == width )
+		return;
+
+	// Narrow the storage too, so that the byte representation stays canonical.
+	// Only a map that isn't a bijection can have an image beyond its size.
+	uint largest = size;
+	for( uint i = 0; i < size; i++ )
+		largest = std::max( largest, Get(i) + 1 );
+
+	while( newCapacity < largest )
+		newCapacity <<= 1;
+
+	if( WidthForCapacity( newCapacity ) < width )
+		Reallocate( newCapacity );
+}
+
+// PointMap.cpp
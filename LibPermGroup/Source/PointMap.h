@@ -0,0 +1,107 @@
+// PointMap.h
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+typedef unsigned int uint;
+
+//------------------------------------------------------------------------------------------
+//                                        PointMap
+//------------------------------------------------------------------------------------------
+
+// This is the storage behind a permutation's map.  Images are stored at the narrowest
+// width (1, 2 or 4 bytes) able to hold every point below the capacity, and maps of
+// degree up to the inline capacity never touch the heap.  Every slot from the size of
+// the map up to its capacity holds its own index, so any point below the capacity can
+// be looked up without a bounds check, and growing the map within its capacity is free.
+class PointMap
+{
+public:
+
+	PointMap( void );
+	PointMap( const PointMap& pointMap );
+	PointMap( PointMap&& pointMap ) noexcept;
+	~PointMap( void );
+
+	PointMap& operator=( const PointMap& pointMap );
+
+	// A heap map is moved by taking its storage.  An inline map still has to be copied, but
+	// that's no more than the inline buffer.  Either way, the moved-from map is the identity.
+	PointMap& operator=( PointMap&& pointMap ) noexcept;
+
+	uint Size( void ) const { return size; }
+	uint Capacity( void ) const { return capacity; }
+	uint Width( void ) const { return width; }
+	bool IsInline( void ) const { return data == inlineBuffer; }
+
+	const uint8_t* Data( void ) const { return data; }
+	uint8_t* Data( void ) { return data; }
+
+	// The given point must be less than the capacity.
+	uint Get( uint i ) const
+	{
+		switch( width )
+		{
+			case 1: return data[i];
+			case 2: return ( ( const uint16_t* )data )[i];
+		}
+		return ( ( const uint32_t* )data )[i];
+	}
+
+	uint operator[]( uint i ) const { return Get(i); }
+
+	// The given point and image must both be less than the capacity.
+	void Set( uint i, uint x )
+	{
+		switch( width )
+		{
+			case 1: data[i] = ( uint8_t )x; return;
+			case 2: ( ( uint16_t* )data )[i] = ( uint16_t )x; return;
+		}
+		( ( uint32_t* )data )[i] = x;
+	}
+
+	void Clear( void );
+	void Resize( uint newSize );
+	void Reserve( uint degree );
+	void Trim( void );
+
+	// These let a kernel write the map directly.  Prepare sets the capacity and makes every
+	// point from the given count onward fixed; the points below it are kept only if the
+	// capacity didn't change.  The kernel then overwrites them and calls SetSize and Trim.
+	void Prepare( uint newCapacity, uint overwriteCount );
+	void SetSize( uint newSize ) { size = newSize; }
+
+	// Asking for a degree past the maximum throws std::length_error, just as asking a vector
+	// for more than it can hold would.  Anything that reads a degree from outside should check
+	// it against the maximum first, and fail without asking.
+	static uint CapacityForDegree( uint degree );
+	static uint WidthForCapacity( uint capacity );
+
+	static const uint inlineCapacity = 128;
+
+	// The capacity is a power of two no smaller than the degree, so this keeps the capacity,
+	// and the bytes of a map at the widest width, well within a uint.  It's 2^28 points, taking 1 GiB.
+	static const uint maxDegree = 1 << 28;
+
+	// Heap storage is over-allocated by this many bytes, so that a 4-byte gather of
+	// the last point of a 1- or 2-byte map stays inside the allocation.
+	static const uint gatherSlack = 4;
+
+private:
+
+	void Reallocate( uint newCapacity );
+	void Free( void );
+	void FillIdentity( uint begin, uint end );
+	static uint8_t* Allocate( uint capacity, uint width );
+
+	uint8_t* data;
+	uint size;
+	uint capacity;
+	uint width;
+	alignas( 8 ) uint8_t inlineBuffer[ inlineCapacity ];
+};
+
+// PointMap.h
@@ -0,0 +1,607 @@
+// PointMapKernels.cpp
+
+#include "PointMapKernels.h"
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#if !defined( PERM_GROUP_DISABLE_SIMD ) && ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 ) )
+#	define POINT_MAP_KERNELS_X86
+#	include <immintrin.h>
+#	if defined( _MSC_VER ) && !defined( __clang__ )
+#		include <intrin.h>
+#		define KERNEL_TARGET( isa )
+#	else
+#		define KERNEL_TARGET( isa ) __attribute__(( target( isa ) ))
+#	endif
+#endif
+
+typedef void ( *ComposeKernel )( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count );
+typedef bool ( *InvertKernel )( const uint8_t* a, uint8_t* inverse, uint size );
+
+static std::atomic< int > currentInstructionSet( -1 );
+
+// Operations whose result overwrites one of their inputs are computed here first.  Being
+// per-thread and reused, it only ever allocates when a thread first sees a large degree.
+static thread_local PointMap scratchMap;
+
+//------------------------------------------------------------------------------------------
+//                                     Scalar kernels
+//------------------------------------------------------------------------------------------
+
+template< typename T >
+static void ComposeScalar( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	const T* mapA = ( const T* )a;
+	const T* mapB = ( const T* )b;
+	T* mapProduct = ( T* )product;
+
+	for( uint i = 0; i < count; i++ )
+		mapProduct[i] = mapB[ mapA[i] ];
+}
+
+template< typename T >
+static bool InvertScalar( const uint8_t* a, uint8_t* inverse, uint size )
+{
+	const T* map = ( const T* )a;
+	T* mapInverse = ( T* )inverse;
+
+	for( uint i = 0; i < size; i++ )
+	{
+		uint j = map[i];
+		if( j >= size )
+			return false;
+
+		mapInverse[j] = ( T )i;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------------------
+//                                      x86 kernels
+//------------------------------------------------------------------------------------------
+
+#if defined( POINT_MAP_KERNELS_X86 )
+
+// A single byte shuffle composes any two permutations of degree 16 or less.
+KERNEL_TARGET( "ssse3" ) static void ComposeU8Shuffle16( const uint8_t* a, const uint8_t* b, uint8_t* product, uint )
+{
+	__m128i table = _mm_loadu_si128( ( const __m128i* )b );
+	__m128i index = _mm_loadu_si128( ( const __m128i* )a );
+	_mm_storeu_si128( ( __m128i* )product, _mm_shuffle_epi8( table, index ) );
+}
+
+// Scatter-free inversion for degree 16 or less: the preimage of each point is found by
+// comparing it against every image at once.  Like the scalar version, the last preimage
+// wins if the map isn't injective, and points with no preimage stay fixed.
+KERNEL_TARGET( "ssse3" ) static bool InvertU8Compare16( const uint8_t* a, uint8_t* inverse, uint size )
+{
+	__m128i images = _mm_loadu_si128( ( const __m128i* )a );
+	uint inside = ( 1u << size ) - 1;
+
+	__m128i outside = _mm_cmpeq_epi8( _mm_max_epu8( images, _mm_set1_epi8( ( char )size ) ), images );
+	if( ( uint )_mm_movemask_epi8( outside ) & inside )
+		return false;
+
+	for( uint j = 0; j < size; j++ )
+	{
+		uint preimages = ( uint )_mm_movemask_epi8( _mm_cmpeq_epi8( images, _mm_set1_epi8( ( char )j ) ) ) & inside;
+		if( preimages )
+		{
+#if defined( _MSC_VER ) && !defined( __clang__ )
+			unsigned long i;
+			_BitScanReverse( &i, preimages );
+			inverse[j] = ( uint8_t )i;
+#else
+			inverse[j] = ( uint8_t )( 31 - __builtin_clz( preimages ) );
+#endif
+		}
+	}
+
+	return true;
+}
+
+// For degree up to 128 the second map is split into 16-byte tables, each of which is
+// looked up with a byte shuffle, and the high nibble of each index picks the right one.
+KERNEL_TARGET( "avx2" ) static void ComposeU8ShuffleSegments( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	uint segmentCount = count / 16;
+
+	__m256i tableArray[ PointMap::inlineCapacity / 16 ];
+	for( uint i = 0; i < segmentCount; i++ )
+		tableArray[i] = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )( b + 16 * i ) ) );
+
+	const __m256i highMask = _mm256_set1_epi8( ( char )0xF0 );
+
+	for( uint i = 0; i < count; i += 32 )
+	{
+		__m256i index = _mm256_loadu_si256( ( const __m256i* )( a + i ) );
+		__m256i high = _mm256_and_si256( index, highMask );
+		__m256i result = _mm256_setzero_si256();
+
+		for( uint j = 0; j < segmentCount; j++ )
+		{
+			__m256i lookup = _mm256_shuffle_epi8( tableArray[j], index );
+			__m256i select = _mm256_cmpeq_epi8( high, _mm256_set1_epi8( ( char )( j << 4 ) ) );
+			result = _mm256_blendv_epi8( result, lookup, select );
+		}
+
+		_mm256_storeu_si256( ( __m256i* )( product + i ), result );
+	}
+}
+
+KERNEL_TARGET( "avx2" ) static void ComposeU8Gather( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	const int* table = ( const int* )b;
+	const __m256i lowMask = _mm256_set1_epi32( 0xFF );
+	const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+
+	for( uint i = 0; i < count; i += 32 )
+	{
+		__m256i gatherArray[4];
+		for( uint j = 0; j < 4; j++ )
+		{
+			__m256i index = _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( a + i + 8 * j ) ) );
+			gatherArray[j] = _mm256_and_si256( _mm256_i32gather_epi32( table, index, 1 ), lowMask );
+		}
+
+		__m256i words01 = _mm256_packus_epi32( gatherArray[0], gatherArray[1] );
+		__m256i words23 = _mm256_packus_epi32( gatherArray[2], gatherArray[3] );
+		__m256i bytes = _mm256_permutevar8x32_epi32( _mm256_packus_epi16( words01, words23 ), order );
+		_mm256_storeu_si256( ( __m256i* )( product + i ), bytes );
+	}
+}
+
+KERNEL_TARGET( "avx2" ) static void ComposeU16Gather( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	const uint16_t* mapA = ( const uint16_t* )a;
+	const int* table = ( const int* )b;
+	const __m256i lowMask = _mm256_set1_epi32( 0xFFFF );
+
+	for( uint i = 0; i < count; i += 16 )
+	{
+		__m256i index0 = _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i* )( mapA + i ) ) );
+		__m256i index1 = _mm256_cvtepu16_epi32( _mm_loadu_si128( ( const __m128i* )( mapA + i + 8 ) ) );
+		__m256i gather0 = _mm256_and_si256( _mm256_i32gather_epi32( table, index0, 2 ), lowMask );
+		__m256i gather1 = _mm256_and_si256( _mm256_i32gather_epi32( table, index1, 2 ), lowMask );
+		__m256i words = _mm256_permute4x64_epi64( _mm256_packus_epi32( gather0, gather1 ), 0xD8 );
+		_mm256_storeu_si256( ( __m256i* )( product + 2 * i ), words );
+	}
+}
+
+KERNEL_TARGET( "avx2" ) static void ComposeU32Gather( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	const int* table = ( const int* )b;
+
+	for( uint i = 0; i < count; i += 8 )
+	{
+		__m256i index = _mm256_loadu_si256( ( const __m256i* )( a + 4 * i ) );
+		_mm256_storeu_si256( ( __m256i* )( product + 4 * i ), _mm256_i32gather_epi32( table, index, 4 ) );
+	}
+}
+
+// The AVX-512 kernels use the masked forms of their intrinsics, with every lane enabled and a
+// zero source, since the unmasked forms pass GCC an undefined source that -Wall warns about.
+static const __mmask16 allLanes16 = 0xFFFF;
+
+KERNEL_TARGET( "avx512f" ) static void ComposeU8Gather512( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	for( uint i = 0; i < count; i += 16 )
+	{
+		__m512i index = _mm512_maskz_cvtepu8_epi32( allLanes16, _mm_loadu_si128( ( const __m128i* )( a + i ) ) );
+		__m512i gather = _mm512_mask_i32gather_epi32( _mm512_setzero_si512(), allLanes16, index, b, 1 );
+		_mm_storeu_si128( ( __m128i* )( product + i ), _mm512_maskz_cvtepi32_epi8( allLanes16, gather ) );
+	}
+}
+
+KERNEL_TARGET( "avx512f" ) static void ComposeU16Gather512( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	const uint16_t* mapA = ( const uint16_t* )a;
+
+	for( uint i = 0; i < count; i += 16 )
+	{
+		__m512i index = _mm512_maskz_cvtepu16_epi32( allLanes16, _mm256_loadu_si256( ( const __m256i* )( mapA + i ) ) );
+		__m512i gather = _mm512_mask_i32gather_epi32( _mm512_setzero_si512(), allLanes16, index, b, 2 );
+		_mm256_storeu_si256( ( __m256i* )( product + 2 * i ), _mm512_maskz_cvtepi32_epi16( allLanes16, gather ) );
+	}
+}
+
+KERNEL_TARGET( "avx512f" ) static void ComposeU32Gather512( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	for( uint i = 0; i < count; i += 16 )
+	{
+		__m512i index = _mm512_loadu_si512( a + 4 * i );
+		_mm512_storeu_si512( product + 4 * i, _mm512_mask_i32gather_epi32( _mm512_setzero_si512(), allLanes16, index, b, 4 ) );
+	}
+}
+
+// With VBMI a whole 64- or 128-byte map is a single permute table.  Beyond that, the
+// top bit of each index picks between two 128-byte lookups.
+KERNEL_TARGET( "avx512f,avx512bw,avx512vbmi" ) static void ComposeU8Permute( const uint8_t* a, const uint8_t* b, uint8_t* product, uint count )
+{
+	if( count <= 64 )
+	{
+		__m512i table = _mm512_loadu_si512( b );
+		__m512i index = _mm512_loadu_si512( a );
+		_mm512_storeu_si512( product, _mm512_maskz_permutexvar_epi8( ~( __mmask64 )0, index, table ) );
+		return;
+	}
+
+	__m512i table0 = _mm512_loadu_si512( b );
+	__m512i table1 = _mm512_loadu_si512( b + 64 );
+
+	if( count <= 128 )
+	{
+		for( uint i = 0; i < count; i += 64 )
+		{
+			__m512i index = _mm512_loadu_si512( a + i );
+			_mm512_storeu_si512( product + i, _mm512_permutex2var_epi8( table0, index, table1 ) );
+		}
+		return;
+	}
+
+	__m512i table2 = _mm512_loadu_si512( b + 128 );
+	__m512i table3 = _mm512_loadu_si512( b + 192 );
+
+	for( uint i = 0; i < count; i += 64 )
+	{
+		__m512i index = _mm512_loadu_si512( a + i );
+		__m512i low = _mm512_permutex2var_epi8( table0, index, table1 );
+		__m512i high = _mm512_permutex2var_epi8( table2, index, table3 );
+		_mm512_storeu_si512( product + i, _mm512_mask_blend_epi8( _mm512_movepi8_mask( index ), low, high ) );
+	}
+}
+
+#endif //POINT_MAP_KERNELS_X86
+
+//------------------------------------------------------------------------------------------
+//                                     PointMapKernels
+//------------------------------------------------------------------------------------------
+
+static uint RoundUp( uint count, uint multiple )
+{
+	return ( count + multiple - 1 ) / multiple * multiple;
+}
+
+// This picks the fastest kernel for the given width and size, along with the number of points
+// it will write, which may run past the size into the identity tail but never past the capacity.
+static ComposeKernel ChooseComposeKernel( uint width, uint size, uint& count )
+{
+	ComposeKernel kernel = nullptr;
+	count = size;
+
+	switch( width )
+	{
+		case 1: kernel = ComposeScalar< uint8_t >; break;
+		case 2: kernel = ComposeScalar< uint16_t >; break;
+		default: kernel = ComposeScalar< uint32_t >; break;
+	}
+
+#if defined( POINT_MAP_KERNELS_X86 )
+	// Every capacity is a multiple of 128 points, and everything past the size of either
+	// map is fixed, so the vector loops are free to run on to a multiple of their stride.
+	PointMapKernels::InstructionSet instructionSet = PointMapKernels::GetInstructionSet();
+
+	if( width == 1 )
+	{
+		if( instructionSet >= PointMapKernels::AVX512VBMIInstructions )
+		{
+			kernel = ComposeU8Permute;
+			count = RoundUp( size, 64 );
+		}
+		else if( size <= 16 && instructionSet >= PointMapKernels::SSSE3Instructions )
+		{
+			kernel = ComposeU8Shuffle16;
+			count = 16;
+		}
+		else if( size <= PointMap::inlineCapacity && instructionSet >= PointMapKernels::AVX2Instructions )
+		{
+			kernel = ComposeU8ShuffleSegments;
+			count = RoundUp( size, 32 );
+		}
+		else if( instructionSet >= PointMapKernels::AVX512Instructions )
+		{
+			kernel = ComposeU8Gather512;
+			count = RoundUp( size, 16 );
+		}
+		else if( instructionSet >= PointMapKernels::AVX2Instructions )
+		{
+			kernel = ComposeU8Gather;
+			count = RoundUp( size, 32 );
+		}
+	}
+	else if( width == 2 )
+	{
+		if( instructionSet >= PointMapKernels::AVX512Instructions )
+		{
+			kernel = ComposeU16Gather512;
+			count = RoundUp( size, 16 );
+		}
+		else if( instructionSet >= PointMapKernels::AVX2Instructions )
+		{
+			kernel = ComposeU16Gather;
+			count = RoundUp( size, 16 );
+		}
+	}
+	else
+	{
+		if( instructionSet >= PointMapKernels::AVX512Instructions )
+		{
+			kernel = ComposeU32Gather512;
+			count = RoundUp( size, 16 );
+		}
+		else if( instructionSet >= PointMapKernels::AVX2Instructions )
+		{
+			kernel = ComposeU32Gather;
+			count = RoundUp( size, 8 );
+		}
+	}
+#endif //POINT_MAP_KERNELS_X86
+
+	return kernel;
+}
+
+static InvertKernel ChooseInvertKernel( uint width, uint size )
+{
+	InvertKernel kernel = nullptr;
+
+	switch( width )
+	{
+		case 1: kernel = InvertScalar< uint8_t >; break;
+		case 2: kernel = InvertScalar< uint16_t >; break;
+		default: kernel = InvertScalar< uint32_t >; break;
+	}
+
+#if defined( POINT_MAP_KERNELS_X86 )
+	// Above degree 16 the comparisons cost more than the stores they would replace.
+	if( width == 1 && size <= 16 && PointMapKernels::GetInstructionSet() >= PointMapKernels::SSSE3Instructions )
+		kernel = InvertU8Compare16;
+#endif //POINT_MAP_KERNELS_X86
+
+	return kernel;
+}
+
+// Permutations with different capacities, which have different lengths of identity tail,
+// are rare enough that they just go through the bounds-checked scalar loop.
+static void ComposeMixed( const PointMap& mapA, const PointMap& mapB, PointMap& product, uint size )
+{
+	product.Reserve( std::max( mapA.Capacity(), mapB.Capacity() ) );
+	product.Resize( size );
+
+	for( uint i = 0; i < size; i++ )
+	{
+		uint j = ( i < mapA.Capacity() ) ? mapA.Get(i) : i;
+		uint k = ( j < mapB.Capacity() ) ? mapB.Get(j) : j;
+		product.Set( i, k );
+	}
+
+	product.Trim();
+}
+
+/*static*/ void PointMapKernels::Compose( const PointMap& mapA, const PointMap& mapB, PointMap& product )
+{
+	if( &product == &mapB )
+	{
+		Compose( mapA, mapB, scratchMap );
+		product = scratchMap;
+		return;
+	}
+
+	uint size = std::max( mapA.Size(), mapB.Size() );
+	if( size == 0 )
+	{
+		product.Clear();
+		return;
+	}
+
+	if( mapA.Capacity() != mapB.Capacity() )
+	{
+		ComposeMixed( mapA, mapB, product, size );
+		return;
+	}
+
+	uint capacity = mapA.Capacity();
+	uint count = 0;
+	ComposeKernel kernel = ChooseComposeKernel( mapA.Width(), size, count );
+
+	product.Prepare( capacity, count );
+	kernel( mapA.Data(), mapB.Data(), product.Data(), count );
+	product.SetSize( size );
+	product.Trim();
+}
+
+/*static*/ bool PointMapKernels::ComposeInverse( const PointMap& mapA, const PointMap& mapB, PointMap& product )
+{
+	if( !Invert( mapB, scratchMap ) )
+		return false;
+
+	Compose( mapA, scratchMap, product );
+	return true;
+}
+
+// Conjugation by mapB relabels every point i as mapB(i), so it takes mapB(i) to mapB(mapA(i)).
+// That is a single scattering pass which needs no inverse.
+/*static*/ void PointMapKernels::Conjugate( const PointMap& mapA, const PointMap& mapB, PointMap& conjugate )
+{
+	if( &conjugate == &mapA || &conjugate == &mapB )
+	{
+		Conjugate( mapA, mapB, scratchMap );
+		conjugate = scratchMap;
+		return;
+	}
+
+	uint size = std::max( mapA.Size(), mapB.Size() );
+	uint capacity = std::max( mapA.Capacity(), mapB.Capacity() );
+
+	conjugate.Prepare( capacity, 0 );
+
+	for( uint i = 0; i < size; i++ )
+	{
+		uint j = ( i < mapA.Capacity() ) ? mapA.Get(i) : i;
+		uint k = ( j < mapB.Capacity() ) ? mapB.Get(j) : j;
+		uint l = ( i < mapB.Capacity() ) ? mapB.Get(i) : i;
+		conjugate.Set( l, k );
+	}
+
+	conjugate.SetSize( size );
+	conjugate.Trim();
+}
+
+/*static*/ bool PointMapKernels::Invert( const PointMap& map, PointMap& inverse )
+{
+	if( &inverse == &map )
+	{
+		bool valid = Invert( map, scratchMap );
+		inverse = scratchMap;
+		return valid;
+	}
+
+	uint size = map.Size();
+	InvertKernel kernel = ChooseInvertKernel( map.Width(), size );
+
+	inverse.Prepare( map.Capacity(), 0 );
+	bool valid = kernel( map.Data(), inverse.Data(), size );
+	inverse.SetSize( size );
+	inverse.Trim();
+	return valid;
+}
+
+// The product rows may be the rows of the first operand, but not of the second.  A stride
+// of zero uses the same row for every product.
+/*static*/ void PointMapKernels::ComposeRows( const uint8_t* rowsA, std::size_t strideA, const uint8_t* rowsB, std::size_t strideB, uint8_t* rowsProduct, uint rowCount, uint size, uint capacity )
+{
+	uint width = PointMap::WidthForCapacity( capacity );
+	std::size_t stride = std::size_t( capacity ) * width;
+
+	uint count = 0;
+	ComposeKernel kernel = ChooseComposeKernel( width, size, count );
+
+	for( uint i = 0; i < rowCount; i++ )
+		kernel( rowsA + i * strideA, rowsB + i * strideB, rowsProduct + i * stride, count );
+}
+
+/*static*/ bool PointMapKernels::InvertRows( const uint8_t* rows, uint8_t* inverseRows, uint rowCount, uint size, uint capacity )
+{
+	uint width = PointMap::WidthForCapacity( capacity );
+	std::size_t stride = std::size_t( capacity ) * width;
+
+	InvertKernel kernel = ChooseInvertKernel( width, size );
+
+	bool valid = true;
+	for( uint i = 0; i < rowCount; i++ )
+		if( !kernel( rows + i * stride, inverseRows + i * stride, size ) )
+			valid = false;
+
+	return valid;
+}
+
+// Maps are kept trimmed and at their narrowest width, so this is a plain byte comparison.
+/*static*/ bool PointMapKernels::IsEqual( const PointMap& mapA, const PointMap& mapB )
+{
+	if( mapA.Size() != mapB.Size() || mapA.Width() != mapB.Width() )
+		return false;
+
+	return memcmp( mapA.Data(), mapB.Data(), mapA.Size() * mapA.Width() ) == 0;
+}
+
+// This reads the map eight bytes at a time, mixing each word in with a multiply and an
+// xor-shift.  The last word may run past the size of the map, but those bytes belong to
+// the identity tail, which is the same for every map of the same size and width.
+/*static*/ uint64_t PointMapKernels::Hash( const PointMap& map )
+{
+	return HashRow( map.Data(), map.Size(), map.Width() );
+}
+
+/*static*/ uint64_t PointMapKernels::HashRow( const uint8_t* row, uint size, uint width )
+{
+	const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+
+	uint byteCount = size * width;
+	uint64_t hash = ( uint64_t( size ) << 8 ) ^ width;
+
+	const uint8_t* data = row;
+	for( uint i = 0; i < byteCount; i += 8 )
+	{
+		uint64_t word;
+		memcpy( &word, data + i, sizeof( word ) );
+		hash = ( hash ^ word ) * multiplier;
+		hash ^= hash >> 29;
+	}
+
+	hash ^= hash >> 32;
+	hash *= 0xD6E8FEB86659FD93ull;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+/*static*/ PointMapKernels::InstructionSet PointMapKernels::GetSupportedInstructionSet( void )
+{
+	static const InstructionSet supportedInstructionSet = []() -> InstructionSet
+	{
+#if defined( POINT_MAP_KERNELS_X86 )
+#	if defined( _MSC_VER ) && !defined( __clang__ )
+		int info[4];
+		__cpuid( info, 0 );
+		int maxLeaf = info[0];
+
+		__cpuid( info, 1 );
+		bool ssse3 = ( info[2] & ( 1 << 9 ) ) != 0;
+		bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+		unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+		bool avx2 = false, avx512f = false, avx512bw = false, avx512vbmi = false;
+
+		if( maxLeaf >= 7 && ( xcr0 & 0x6 ) == 0x6 )
+		{
+			__cpuidex( info, 7, 0 );
+			avx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+			if( ( xcr0 & 0xE6 ) == 0xE6 )
+			{
+				avx512f = ( info[1] & ( 1 << 16 ) ) != 0;
+				avx512bw = ( info[1] & ( 1 << 30 ) ) != 0;
+				avx512vbmi = ( info[2] & ( 1 << 1 ) ) != 0;
+			}
+		}
+#	else
+		__builtin_cpu_init();
+		bool ssse3 = __builtin_cpu_supports( "ssse3" );
+		bool avx2 = __builtin_cpu_supports( "avx2" );
+		bool avx512f = __builtin_cpu_supports( "avx512f" );
+		bool avx512bw = __builtin_cpu_supports( "avx512bw" );
+		bool avx512vbmi = __builtin_cpu_supports( "avx512vbmi" );
+#	endif
+		if( avx512f && avx512bw && avx512vbmi && avx2 )
+			return AVX512VBMIInstructions;
+		if( avx512f && avx2 )
+			return AVX512Instructions;
+		if( avx2 )
+			return AVX2Instructions;
+		if( ssse3 )
+			return SSSE3Instructions;
+#endif //POINT_MAP_KERNELS_X86
+		return ScalarInstructions;
+	}();
+
+	return supportedInstructionSet;
+}
+
+/*static*/ PointMapKernels::InstructionSet PointMapKernels::GetInstructionSet( void )
+{
+	int instructionSet = currentInstructionSet.load( std::memory_order_relaxed );
+	if( instructionSet < 0 )
+	{
+		instructionSet = GetSupportedInstructionSet();
+		currentInstructionSet.store( instructionSet, std::memory_order_relaxed );
+	}
+
+	return ( InstructionSet )instructionSet;
+}
+
+// Asking for more than the processor supports just gets what it does support.
+/*static*/ void PointMapKernels::SetInstructionSet( InstructionSet instructionSet )
+{
+	instructionSet = std::min( instructionSet, GetSupportedInstructionSet() );
+	currentInstructionSet.store( instructionSet, std::memory_order_relaxed );
+}
+
+// PointMapKernels.cpp
@@ -0,0 +1,63 @@
+// PointMapKernels.h
+
+#pragma once
+
+#include "PointMap.h"
+
+//------------------------------------------------------------------------------------------
+//                                     PointMapKernels
+//------------------------------------------------------------------------------------------
+
+// These are the inner loops of permutation arithmetic.  Each one has a portable scalar
+// version and, on x86, vector versions chosen at start-up from what the processor supports.
+// All versions give identical results for valid permutations, and the instruction set can
+// be lowered at run-time to check exactly that.
+class PointMapKernels
+{
+public:
+
+	enum InstructionSet
+	{
+		ScalarInstructions,
+		SSSE3Instructions,
+		AVX2Instructions,
+		AVX512Instructions,
+		AVX512VBMIInstructions
+	};
+
+	// In all of these the result may be the same object as any of the inputs.
+
+	// The product is the map taking i to mapB(mapA(i)).
+	static void Compose( const PointMap& mapA, const PointMap& mapB, PointMap& product );
+
+	// The product is mapA followed by the inverse of mapB.  This fails if mapB can't be inverted.
+	static bool ComposeInverse( const PointMap& mapA, const PointMap& mapB, PointMap& product );
+
+	// The conjugate is the inverse of mapB, followed by mapA, followed by mapB.
+	static void Conjugate( const PointMap& mapA, const PointMap& mapB, PointMap& conjugate );
+
+	// This fails if the map sends a point outside of its own domain.
+	static bool Invert( const PointMap& map, PointMap& inverse );
+
+	static bool IsEqual( const PointMap& mapA, const PointMap& mapB );
+
+	// Maps that are equal as permutations always hash the same, because they
+	// are trimmed and stored at the same width.
+	static uint64_t Hash( const PointMap& map );
+
+	// These work on rows of points stored one after another, each a whole capacity long and
+	// fixed from the given size onward, as in a permutation batch.  The buffer must have
+	// PointMap::gatherSlack bytes to spare past its last row.  Inverse rows must be separate
+	// from the rows being inverted and already fixed past the size.
+	static void ComposeRows( const uint8_t* rowsA, std::size_t strideA, const uint8_t* rowsB, std::size_t strideB, uint8_t* rowsProduct, uint rowCount, uint size, uint capacity );
+	static bool InvertRows( const uint8_t* rows, uint8_t* inverseRows, uint rowCount, uint size, uint capacity );
+
+	// This hashes a row the same way as a map of the given size and width.
+	static uint64_t HashRow( const uint8_t* row, uint size, uint width );
+
+	static InstructionSet GetInstructionSet( void );
+	static InstructionSet GetSupportedInstructionSet( void );
+	static void SetInstructionSet( InstructionSet instructionSet );
+};
+
+// PointMapKernels.h
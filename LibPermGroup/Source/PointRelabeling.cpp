@@ -0,0 +1,113 @@
+// PointRelabeling.cpp
+
+#include "PointRelabeling.h"
+
+//------------------------------------------------------------------------------------------
+//                                     PointRelabeling
+//------------------------------------------------------------------------------------------
+
+/*static*/ const uint PointRelabeling::invalidPoint;
+
+PointRelabeling::PointRelabeling( void )
+{
+}
+
+PointRelabeling::~PointRelabeling( void )
+{
+}
+
+bool PointRelabeling::Build( const PermutationSet& generatorSet, const std::vector< uint >& extraPointArray )
+{
+	pointArray.clear();
+	densePointArray.clear();
+
+	NaturalNumberSet domainSet;
+	NaturalNumberSet unstableSet;
+
+	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
+	{
+		const Permutation& generator = *iter;
+		if( !generator.IsValid() )
+			return false;
+
+		generator.GetUnstableSet( unstableSet );
+		for( NaturalNumberSet::const_iterator pointIter = unstableSet.cbegin(); pointIter != unstableSet.cend(); pointIter++ )
+			domainSet.AddMember( *pointIter );
+	}
+
+	for( uint i = 0; i < extraPointArray.size(); i++ )
+		domainSet.AddMember( extraPointArray[i] );
+
+	if( domainSet.IsEmpty() )
+		return true;
+
+	densePointArray.resize( domainSet.Max() + 1, invalidPoint );
+	for( NaturalNumberSet::const_iterator iter = domainSet.cbegin(); iter != domainSet.cend(); iter++ )
+	{
+		densePointArray[ *iter ] = ( uint )pointArray.size();
+		pointArray.push_back( *iter );
+	}
+
+	return true;
+}
+
+bool PointRelabeling::IsIdentity( void ) const
+{
+	// The points are in increasing order, so they're 0 through k-1 just when the last one is k-1.
+	return pointArray.size() == 0 || pointArray.back() == pointArray.size() - 1;
+}
+
+uint PointRelabeling::ToDensePoint( uint point ) const
+{
+	if( point >= densePointArray.size() )
+		return invalidPoint;
+
+	return densePointArray[ point ];
+}
+
+bool PointRelabeling::ToDense( const Permutation& permutation, Permutation& densePermutation ) const
+{
+	for( uint i = 0; i < permutation.map.Size(); i++ )
+		if( permutation.map[i] != i && ToDensePoint(i) == invalidPoint )
+			return false;
+
+	densePermutation.DefineIdentity();
+	densePermutation.map.Reserve( Degree() );
+
+	for( uint i = 0; i < pointArray.size(); i++ )
+		densePermutation.Define( i, densePointArray[ permutation.Evaluate( pointArray[i] ) ] );
+
+	CopyWord( permutation, densePermutation );
+	return true;
+}
+
+void PointRelabeling::FromDense( const Permutation& densePermutation, Permutation& permutation ) const
+{
+	permutation.DefineIdentity();
+	if( pointArray.size() > 0 )
+		permutation.map.Reserve( pointArray.back() + 1 );
+
+	for( uint i = 0; i < pointArray.size(); i++ )
+		permutation.Define( pointArray[i], pointArray[ densePermutation.Evaluate(i) ] );
+
+	CopyWord( densePermutation, permutation );
+}
+
+void PointRelabeling::FromDense( const NaturalNumberSet& densePointSet, NaturalNumberSet& pointSet ) const
+{
+	pointSet.RemoveAllMembers();
+
+	for( NaturalNumberSet::const_iterator iter = densePointSet.cbegin(); iter != densePointSet.cend(); iter++ )
+		pointSet.AddMember( FromDensePoint( *iter ) );
+}
+
+/*static*/ void PointRelabeling::CopyWord( const Permutation& permutation, Permutation& copyPermutation )
+{
+	copyPermutation.word.reset();
+	if( permutation.word )
+		copyPermutation.word = std::make_unique< ElementArray >( *permutation.word );
+
+	copyPermutation.wordProgram = permutation.wordProgram;
+}
+
+// PointRelabeling.cpp
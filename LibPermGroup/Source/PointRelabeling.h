@@ -0,0 +1,56 @@
+// PointRelabeling.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+//                                     PointRelabeling
+//------------------------------------------------------------------------------------------
+
+// A permutation's map runs all the way up to its largest moved point, so every product costs
+// as much as the largest label in use, even when most of the points below it are never moved
+// by anything, as happens with facelet numberings that have gaps or fixed centres.  This maps
+// just the points that matter onto 0 through k-1, in increasing order, so that work can be
+// done in that dense domain, and the results mapped back to the original labels afterwards.
+class PointRelabeling
+{
+public:
+
+	PointRelabeling( void );
+	~PointRelabeling( void );
+
+	// The domain is every point moved by any of the generators, along with the given extra
+	// points, such as those of a base.  This fails if any generator isn't a permutation.
+	bool Build( const PermutationSet& generatorSet, const std::vector< uint >& extraPointArray );
+
+	// This is when the domain is already 0 through k-1, so that relabeling would change nothing.
+	bool IsIdentity( void ) const;
+
+	uint Degree( void ) const { return ( uint )pointArray.size(); }
+
+	// A point outside the domain has no dense label, and gives the invalid point.
+	uint ToDensePoint( uint point ) const;
+	uint FromDensePoint( uint densePoint ) const { return pointArray[ densePoint ]; }
+
+	// Words are carried over as they are.  Making a permutation dense fails if it moves any
+	// point outside the domain.
+	bool ToDense( const Permutation& permutation, Permutation& densePermutation ) const;
+	void FromDense( const Permutation& densePermutation, Permutation& permutation ) const;
+	void FromDense( const NaturalNumberSet& densePointSet, NaturalNumberSet& pointSet ) const;
+
+	static const uint invalidPoint = 0xFFFFFFFF;
+
+	// Entry i is the original label of dense point i.
+	std::vector< uint > pointArray;
+
+	// This is the inverse of the above, indexed by original label.
+	std::vector< uint > densePointArray;
+
+private:
+
+	static void CopyWord( const Permutation& permutation, Permutation& copyPermutation );
+};
+
+// PointRelabeling.h
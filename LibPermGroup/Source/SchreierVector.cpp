@@ -0,0 +1,224 @@
+// SchreierVector.cpp
+
+#include "SchreierVector.h"
+#include "PointRelabeling.h"
+
+//------------------------------------------------------------------------------------------
+//                                     SchreierVector
+//------------------------------------------------------------------------------------------
+
+/*static*/ const uint SchreierVector::rootLabel;
+/*static*/ const uint SchreierVector::noLabel;
+/*static*/ const uint SchreierVector::noSlot;
+
+SchreierVector::SchreierVector( uint rootPoint, uint cacheSize )
+{
+	this->rootPoint = rootPoint;
+	this->cacheSize = cacheSize;
+	cacheFrozen = false;
+	nextCacheSlot = 0;
+
+	labelArray.resize( rootPoint + 1, noLabel );
+	labelArray[ rootPoint ] = rootLabel;
+	orbitArray.push_back( rootPoint );
+}
+
+SchreierVector::~SchreierVector( void )
+{
+}
+
+uint SchreierVector::AddGenerator( const Permutation& generator )
+{
+	uint generatorIndex = ( uint )generatorArray.size();
+
+	generatorArray.emplace_back();
+	generatorArray.back().SetCopy( generator, false );
+
+	inverseGeneratorArray.emplace_back();
+	generatorArray.back().GetInverse( inverseGeneratorArray.back() );
+
+	uint oldOrbitSize = ( uint )orbitArray.size();
+	for( uint i = 0; i < oldOrbitSize; i++ )
+		Reach( orbitArray[i], generatorIndex );
+
+	for( uint i = oldOrbitSize; i < orbitArray.size(); i++ )
+		for( uint j = 0; j < generatorArray.size(); j++ )
+			Reach( orbitArray[i], j );
+
+	return generatorIndex;
+}
+
+void SchreierVector::Reach( uint point, uint generatorIndex )
+{
+	uint image = generatorArray[ generatorIndex ].Evaluate( point );
+	if( IsInOrbit( image ) )
+		return;
+
+	if( image >= labelArray.size() )
+		labelArray.resize( image + 1, noLabel );
+
+	labelArray[ image ] = generatorIndex;
+	orbitArray.push_back( image );
+}
+
+bool SchreierVector::IsInOrbit( uint point ) const
+{
+	return point < labelArray.size() && labelArray[ point ] != noLabel;
+}
+
+// The walk builds up the part of the representative that lies between the point it has got
+// to and the given point, so each generator stepped back over goes on the left.
+bool SchreierVector::GetRepresentative( uint point, Permutation& representative ) const
+{
+	if( !IsInOrbit( point ) )
+		return false;
+
+	representative.word.reset();
+	representative.wordProgram.reset();
+	representative.DefineIdentity();
+
+	bool cached = false;
+
+	uint walkPoint = point;
+	while( labelArray[ walkPoint ] != rootLabel )
+	{
+		if( walkPoint < cacheSlotArray.size() && cacheSlotArray[ walkPoint ] != noSlot )
+		{
+			representative.MultiplyOnLeft( cacheArray[ cacheSlotArray[ walkPoint ] ] );
+			cached = ( walkPoint == point );
+			break;
+		}
+
+		uint label = labelArray[ walkPoint ];
+		representative.MultiplyOnLeft( generatorArray[ label ] );
+		walkPoint = inverseGeneratorArray[ label ].Evaluate( walkPoint );
+	}
+
+	if( !cached && !cacheFrozen && point != rootPoint )
+		Cache( point, representative );
+
+	return true;
+}
+
+void SchreierVector::Cache( uint point, const Permutation& representative ) const
+{
+	if( cacheSize == 0 )
+		return;
+
+	if( cacheSlotArray.size() < labelArray.size() )
+		cacheSlotArray.resize( labelArray.size(), noSlot );
+
+	uint slot = nextCacheSlot;
+	if( cacheArray.size() < cacheSize )
+	{
+		cacheArray.emplace_back();
+		cachePointArray.push_back( point );
+	}
+	else
+	{
+		cacheSlotArray[ cachePointArray[ slot ] ] = noSlot;
+		cachePointArray[ slot ] = point;
+	}
+
+	cacheArray[ slot ].SetCopy( representative, false );
+	cacheSlotArray[ point ] = slot;
+	nextCacheSlot = ( slot + 1 ) % cacheSize;
+}
+
+// Whatever a permutation only works out about itself when first asked is worked out here for
+// every one a walk might read, so that the walks don't write anything shared.
+void SchreierVector::SetCacheFrozen( bool frozen )
+{
+	cacheFrozen = frozen;
+	if( !frozen )
+		return;
+
+	PermutationArray* permutationArrayArray[] = { &generatorArray, &inverseGeneratorArray, &cacheArray };
+	for( uint i = 0; i < 3; i++ )
+	{
+		const PermutationArray& permutationArray = *permutationArrayArray[i];
+		for( uint j = 0; j < permutationArray.size(); j++ )
+			permutationArray[j].IsSparse();
+	}
+}
+
+void SchreierVector::ClearCache( void )
+{
+	cacheArray.clear();
+	cachePointArray.clear();
+	cacheSlotArray.clear();
+	nextCacheSlot = 0;
+}
+
+// Each representative is its parent's followed by the generator that reached its point, and
+// the parent's is always made first, so no walks are needed here.
+void SchreierVector::GetRepresentativeSet( PermutationSet& representativeSet ) const
+{
+	representativeSet.clear();
+	representativeSet.reserve( orbitArray.size() );
+
+	std::vector< uint > positionArray( labelArray.size(), 0 );
+	std::vector< PermutationSet::Handle > handleArray;
+	handleArray.reserve( orbitArray.size() );
+
+	for( uint i = 0; i < orbitArray.size(); i++ )
+	{
+		uint point = orbitArray[i];
+		positionArray[ point ] = i;
+
+		Permutation representative;
+		uint label = labelArray[ point ];
+		if( label != rootLabel )
+		{
+			uint parentPoint = inverseGeneratorArray[ label ].Evaluate( point );
+			representative.Multiply( representativeSet.Get( handleArray[ positionArray[ parentPoint ] ] ), generatorArray[ label ] );
+		}
+
+		handleArray.push_back( representativeSet.insert( std::move( representative ) ).first.handle );
+	}
+}
+
+void SchreierVector::FromDense( const PointRelabeling& relabeling )
+{
+	ClearCache();
+
+	std::vector< uint > denseLabelArray;
+	denseLabelArray.swap( labelArray );
+
+	rootPoint = relabeling.FromDensePoint( rootPoint );
+
+	uint maxPoint = rootPoint;
+	for( uint i = 0; i < orbitArray.size(); i++ )
+		if( relabeling.FromDensePoint( orbitArray[i] ) > maxPoint )
+			maxPoint = relabeling.FromDensePoint( orbitArray[i] );
+
+	labelArray.resize( maxPoint + 1, noLabel );
+	for( uint i = 0; i < orbitArray.size(); i++ )
+	{
+		uint densePoint = orbitArray[i];
+		orbitArray[i] = relabeling.FromDensePoint( densePoint );
+		labelArray[ orbitArray[i] ] = denseLabelArray[ densePoint ];
+	}
+
+	PermutationArray* permutationArrayArray[] = { &generatorArray, &inverseGeneratorArray };
+	for( uint i = 0; i < 2; i++ )
+	{
+		PermutationArray& permutationArray = *permutationArrayArray[i];
+		for( uint j = 0; j < permutationArray.size(); j++ )
+		{
+			Permutation densePermutation;
+			densePermutation.SetCopy( permutationArray[j], false );
+			relabeling.FromDense( densePermutation, permutationArray[j] );
+		}
+	}
+}
+
+void SchreierVector::Print( std::ostream& ostream ) const
+{
+	ostream << "Orbit of " << rootPoint << " (point: generator index):\n";
+
+	for( uint i = 1; i < orbitArray.size(); i++ )
+		ostream << orbitArray[i] << ": " << labelArray[ orbitArray[i] ] << "\n";
+}
+
+// SchreierVector.cpp
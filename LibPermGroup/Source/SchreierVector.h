@@ -0,0 +1,87 @@
+// SchreierVector.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <vector>
+#include <iostream>
+
+class PointRelabeling;
+
+//------------------------------------------------------------------------------------------
+//                                     SchreierVector
+//------------------------------------------------------------------------------------------
+
+// This is the orbit of a root point under a group's generators, where every point in the orbit
+// only remembers which generator first reached it, rather than a whole coset representative.
+// A point's representative, which takes the root to it, is made on demand by walking back
+// from the point to the root, one inverse generator at a time, and multiplying the generators
+// along the way.  This costs a product per step of the walk, but the memory for the orbit is
+// then a label per point, instead of a permutation per point.  A few of the representatives
+// made can be kept, so that a walk that comes across one of them can stop there.
+class SchreierVector
+{
+public:
+
+	SchreierVector( uint rootPoint, uint cacheSize );
+	~SchreierVector( void );
+
+	// The orbit is grown to take in the new generator, and its index is returned.  Points that
+	// were already in the orbit are only taken under the new generator, but any points found
+	// along the way are taken under all of them, so that every new point is appended to the
+	// orbit array after the points that were already there.
+	uint AddGenerator( const Permutation& generator );
+
+	bool IsInOrbit( uint point ) const;
+	uint OrbitSize( void ) const { return ( uint )orbitArray.size(); }
+
+	// The representative has no word, just as a representative made in the transversal set
+	// from an unnamed identity has none.  This fails if the point isn't in the orbit.
+	bool GetRepresentative( uint point, Permutation& representative ) const;
+
+	// These are all the representatives, in the order of the orbit array, starting with the
+	// identity at the root.
+	void GetRepresentativeSet( PermutationSet& representativeSet ) const;
+
+	// While the cache is frozen, walks still stop at the representatives already in it, but no
+	// more are added, so that any number of threads can make representatives at once.
+	void SetCacheFrozen( bool frozen );
+
+	void FromDense( const PointRelabeling& relabeling );
+	void Print( std::ostream& ostream ) const;
+
+	static const uint rootLabel = 0xFFFFFFFE;
+	static const uint noLabel = 0xFFFFFFFF;
+
+	uint rootPoint;
+
+	// The orbit, in the order its points were found.  Every point comes after the one it was
+	// reached from.
+	std::vector< uint > orbitArray;
+
+	// Indexed by point, this is the index of the generator that first took some point of the
+	// orbit to it, or one of the labels above.
+	std::vector< uint > labelArray;
+
+	// These are kept without their words, since only their maps are ever needed.
+	PermutationArray generatorArray;
+	PermutationArray inverseGeneratorArray;
+
+private:
+
+	void Reach( uint point, uint generatorIndex );
+	void Cache( uint point, const Permutation& representative ) const;
+	void ClearCache( void );
+
+	static const uint noSlot = 0xFFFFFFFF;
+
+	// Once the cache is full, each new representative takes the place of the oldest one.
+	uint cacheSize;
+	bool cacheFrozen;
+	mutable PermutationArray cacheArray;
+	mutable std::vector< uint > cachePointArray;
+	mutable std::vector< uint > cacheSlotArray;
+	mutable uint nextCacheSlot;
+};
+
+// SchreierVector.h
@@ -0,0 +1,69 @@
+// ScratchArena.cpp
+
+#include "ScratchArena.h"
+
+//------------------------------------------------------------------------------------------
+//                                      ScratchArena
+//------------------------------------------------------------------------------------------
+
+/*static*/ const std::size_t ScratchArena::minBlockSize;
+
+ScratchArena::ScratchArena( void )
+{
+	blockIndex = 0;
+	offset = 0;
+}
+
+ScratchArena::~ScratchArena( void )
+{
+	for( uint i = 0; i < blockArray.size(); i++ )
+		delete[] blockArray[i].data;
+}
+
+/*static*/ ScratchArena& ScratchArena::ForThread( void )
+{
+	static thread_local ScratchArena arena;
+	return arena;
+}
+
+// A request that doesn't fit in what's left of the current block moves on to the next one,
+// leaving the rest of the current block unused until the arena is wound back past it.
+void* ScratchArena::Allocate( std::size_t size, std::size_t alignment )
+{
+	while( blockIndex < blockArray.size() )
+	{
+		const Block& block = blockArray[ blockIndex ];
+		std::size_t padding = ( alignment - std::uintptr_t( block.data + offset ) % alignment ) % alignment;
+		if( offset + padding + size <= block.size )
+		{
+			uint8_t* data = block.data + offset + padding;
+			offset += padding + size;
+			return data;
+		}
+
+		blockIndex++;
+		offset = 0;
+	}
+
+	Block block;
+	block.size = ( size + alignment > minBlockSize ) ? ( size + alignment ) : minBlockSize;
+	block.data = new uint8_t[ block.size ];
+	blockArray.push_back( block );
+
+	return Allocate( size, alignment );
+}
+
+ScratchArena::Scope::Scope( void )
+{
+	arena = &ScratchArena::ForThread();
+	blockIndex = arena->blockIndex;
+	offset = arena->offset;
+}
+
+ScratchArena::Scope::~Scope( void )
+{
+	arena->blockIndex = blockIndex;
+	arena->offset = offset;
+}
+
+// ScratchArena.cpp
@@ -0,0 +1,92 @@
+// ScratchArena.h
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned int uint;
+
+//------------------------------------------------------------------------------------------
+//                                      ScratchArena
+//------------------------------------------------------------------------------------------
+
+// Containers that only live for the length of a call on a hot path are made out of this,
+// rather than the heap.  Memory is handed out by bumping an offset into the current block,
+// and is never given back piece by piece.  Instead, a scope notes where the arena was when
+// it was opened, and winds it back there when it closes, which costs the same however much
+// was allocated in between.  Scopes nest, so a call can recurse into one that opens its own.
+// The blocks are kept when the arena is wound back, so once it has grown to what a thread
+// needs, it no longer touches the heap at all.  Each thread has its own arena.
+class ScratchArena
+{
+public:
+
+	ScratchArena( void );
+	~ScratchArena( void );
+
+	void* Allocate( std::size_t size, std::size_t alignment );
+
+	static ScratchArena& ForThread( void );
+
+	// Anything allocated from the thread's arena while this exists must be done with by the
+	// time it's destroyed, so it should be made before any container that uses the arena.
+	class Scope
+	{
+	public:
+
+		Scope( void );
+		~Scope( void );
+
+		ScratchArena* arena;
+		uint blockIndex;
+		std::size_t offset;
+	};
+
+	static const std::size_t minBlockSize = 64 * 1024;
+
+private:
+
+	struct Block
+	{
+		uint8_t* data;
+		std::size_t size;
+	};
+
+	std::vector< Block > blockArray;
+	uint blockIndex;
+	std::size_t offset;
+};
+
+//------------------------------------------------------------------------------------------
+//                                    ScratchAllocator
+//------------------------------------------------------------------------------------------
+
+// This lets a standard container be made in the thread's scratch arena.  Freeing does nothing,
+// since the memory is only reclaimed when the enclosing scope closes.
+template< typename Type >
+class ScratchAllocator
+{
+public:
+
+	typedef Type value_type;
+
+	ScratchAllocator( void ) : arena( &ScratchArena::ForThread() ) {}
+
+	template< typename OtherType >
+	ScratchAllocator( const ScratchAllocator< OtherType >& allocator ) : arena( allocator.arena ) {}
+
+	Type* allocate( std::size_t count ) { return ( Type* )arena->Allocate( count * sizeof( Type ), alignof( Type ) ); }
+	void deallocate( Type*, std::size_t ) {}
+
+	template< typename OtherType >
+	bool operator==( const ScratchAllocator< OtherType >& allocator ) const { return arena == allocator.arena; }
+
+	template< typename OtherType >
+	bool operator!=( const ScratchAllocator< OtherType >& allocator ) const { return arena != allocator.arena; }
+
+	ScratchArena* arena;
+};
+
+// ScratchArena.h
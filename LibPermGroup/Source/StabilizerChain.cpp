@@ -2,18 +2,32 @@
 
 #include "StabilizerChain.h"
 #include "PermutationStream.h"
+#include "PermutationBatch.h"
+#include "WordEvaluator.h"
+#include "PointRelabeling.h"
+#include "SchreierVector.h"
+#include "PermutationCodec.h"
 #include <time.h>
+#include <algorithm>
 #include "rapidjson/prettywriter.h"
 
 StabilizerChain::StabilizerChain( void )
 {
 	group = nullptr;
 	logStream = nullptr;
+	useSchreierVectors = false;
+	representativeCacheSize = 64;
+	randomSiftLimit = 0;
+	randomSeed = 0;
+	verifyRandomChain = false;
+	threadCount = 1;
+	threadPool = nullptr;
 }
 
 /*virtual*/ StabilizerChain::~StabilizerChain( void )
 {
 	delete group;
+	delete threadPool;
 }
 
 StabilizerChain* StabilizerChain::Clone( void ) const
@@ -94,6 +108,10 @@ bool StabilizerChain::LoadFromJsonString( const std::string& jsonString )
 		baseArray.push_back( stabilizerPointSet );
 	}
 
+	// The base comes after the groups here, so they can only be indexed now.
+	for( Group* subGroup = group; subGroup; subGroup = subGroup->subGroup )
+		subGroup->IndexTransversalSet();
+
 	return true;
 }
 
@@ -130,8 +148,145 @@ bool StabilizerChain::SaveToJsonString( std::string& jsonString ) const
 	return true;
 }
 
-// This is an attempt to impliment the Schreier-Sims algorithm.
+// The binary form starts with these bytes and then a version number.  See PermutationEncoder
+// for how the permutations in it are written.
+static const char binaryMagic[] = "PGSC";
+static const uint binaryVersion = 1;
+
+bool StabilizerChain::LoadFromBinaryString( const std::string& binaryString )
+{
+	delete group;
+	group = new Group( this, nullptr, 0 );
+
+	std::size_t magicSize = sizeof( binaryMagic ) - 1;
+	if( binaryString.compare( 0, magicSize, binaryMagic ) != 0 )
+		return false;
+
+	PermutationDecoder decoder( binaryString, magicSize );
+
+	uint version = 0;
+	if( !decoder.DecodeUint( version ) || version != binaryVersion )
+		return false;
+
+	// The base comes first, so that each group's stabilizer offset can be checked against it.
+	uint baseSize = 0;
+	if( !decoder.DecodeUint( baseSize ) || baseSize > binaryString.size() )
+		return false;
+
+	baseArray.clear();
+	baseArray.resize( baseSize );
+	for( uint i = 0; i < baseSize; i++ )
+		if( !decoder.DecodeSet( baseArray[i] ) )
+			return false;
+
+	if( !group->LoadRecursive( decoder ) )
+		return false;
+
+	return decoder.AtEnd();
+}
+
+bool StabilizerChain::SaveToBinaryString( std::string& binaryString ) const
+{
+	if( !group )
+		return false;
+
+	binaryString = binaryMagic;
+
+	PermutationEncoder encoder( binaryString );
+	encoder.EncodeUint( binaryVersion );
+
+	encoder.EncodeUint( baseArray.size() );
+	for( uint i = 0; i < baseArray.size(); i++ )
+		encoder.EncodeSet( baseArray[i] );
+
+	return group->SaveRecursive( encoder );
+}
+
+// The chain is worked out over just the points that are moved by a generator or are in the
+// base, relabeled as 0 through k-1, so that none of the products made along the way pay for
+// points that never move.  It's then put back in terms of the original labels.
 bool StabilizerChain::Generate( const PermutationSet& generatorSet, const UintArray& baseArray )
+{
+	PointRelabeling relabeling;
+	if( !relabeling.Build( generatorSet, baseArray ) )
+		return false;
+
+	if( relabeling.IsIdentity() )
+		return ( randomSiftLimit > 0 ) ? RandomSchreierSims( generatorSet, baseArray ) : SchreierSims( generatorSet, baseArray );
+
+	if( logStream )
+		*logStream << "Relabeling " << relabeling.Degree() << " points up to " << relabeling.pointArray.back() << ".\n";
+
+	PermutationSet denseGeneratorSet;
+	denseGeneratorSet.reserve( generatorSet.size() );
+	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
+	{
+		Permutation denseGenerator;
+		if( !relabeling.ToDense( *iter, denseGenerator ) )
+			return false;
+
+		denseGeneratorSet.insert( std::move( denseGenerator ) );
+	}
+
+	UintArray denseBaseArray;
+	for( uint i = 0; i < baseArray.size(); i++ )
+		denseBaseArray.push_back( relabeling.ToDensePoint( baseArray[i] ) );
+
+	bool generated = ( randomSiftLimit > 0 ) ? RandomSchreierSims( denseGeneratorSet, denseBaseArray ) : SchreierSims( denseGeneratorSet, denseBaseArray );
+	if( !generated )
+		return false;
+
+	FromDense( relabeling );
+	return true;
+}
+
+// The transversals are rebuilt in the order they were made, so that nothing which walks
+// them sees any difference other than the labels.
+void StabilizerChain::FromDense( const PointRelabeling& relabeling )
+{
+	for( uint i = 0; i < baseArray.size(); i++ )
+	{
+		NaturalNumberSet densePointSet;
+		densePointSet.Copy( baseArray[i] );
+		relabeling.FromDense( densePointSet, baseArray[i] );
+	}
+
+	for( Group* subGroup = group; subGroup; subGroup = subGroup->subGroup )
+	{
+		PermutationSet* permutationSetArray[] = { &subGroup->generatorSet, &subGroup->transversalSet };
+		for( uint i = 0; i < 2; i++ )
+		{
+			PermutationSet& permutationSet = *permutationSetArray[i];
+			PermutationSet densePermutationSet( std::move( permutationSet ) );
+			permutationSet.reserve( densePermutationSet.size() );
+
+			for( PermutationSet::const_iterator iter = densePermutationSet.cbegin(); iter != densePermutationSet.cend(); iter++ )
+			{
+				Permutation permutation;
+				relabeling.FromDense( *iter, permutation );
+				permutationSet.insert( std::move( permutation ) );
+			}
+		}
+
+		NaturalNumberSet denseOrbitSet;
+		denseOrbitSet.Copy( subGroup->orbitSet );
+		relabeling.FromDense( denseOrbitSet, subGroup->orbitSet );
+
+		if( subGroup->schreierVector )
+			subGroup->schreierVector->FromDense( relabeling );
+
+		subGroup->IndexTransversalSet();
+	}
+}
+
+// Each Schreier vector is replaced by the transversal set it stands for.
+void StabilizerChain::MaterializeTransversals( void )
+{
+	for( Group* subGroup = group; subGroup; subGroup = subGroup->subGroup )
+		subGroup->MaterializeTransversal();
+}
+
+void StabilizerChain::BeginGeneration( const UintArray& baseArray )
 {
 	this->baseArray.clear();
 	for( uint i = 0; i < baseArray.size(); i++ )
@@ -144,8 +299,20 @@ bool StabilizerChain::Generate( const PermutationSet& generatorSet, const UintAr
 	delete group;
 	group = new Group( this, nullptr, 0 );
 
+	delete threadPool;
+	threadPool = ( threadCount > 1 ) ? new ThreadPool( threadCount ) : nullptr;
+
 	if( logStream )
 		*logStream << "Generating stabilizer chain!!!\n";
+}
+
+// This is an attempt to impliment the Schreier-Sims algorithm.
+bool StabilizerChain::SchreierSims( const PermutationSet& generatorSet, const UintArray& baseArray )
+{
+	BeginGeneration( baseArray );
+
+	if( this->baseArray.size() == 0 )
+		return false;
 
 	uint size = ( uint )generatorSet.size();
 	uint count = 0;
@@ -174,11 +341,113 @@ bool StabilizerChain::Generate( const PermutationSet& generatorSet, const UintAr
 			Print( *logStream );
 	}
 
+	return FinishGeneration();
+}
+
+// This follows the randomized Schreier-Sims algorithm as it's described in the Handbook of
+// Computational Group Theory, by Holt, Eick and O'Brien.  Each level's orbit is grown under
+// its generators as they're added, but no Schreier generators are made.  Instead, random
+// elements of the group are sifted down the chain, and whatever is left of one that doesn't
+// sift to the identity becomes a new generator at every level it belongs to.  This doesn't
+// need to be given a whole base, since a base point is added whenever something is left that
+// fixes all the others.  Completing the chain deterministically extends the base the same way.
+bool StabilizerChain::RandomSchreierSims( const PermutationSet& generatorSet, const UintArray& baseArray )
+{
+	BeginGeneration( baseArray );
+
+	if( this->baseArray.size() == 0 )
+		return false;
+
+	// The generators go in at the top first, so that its orbit is complete before anything is sifted.
+	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
+	{
+		const Permutation& generator = *iter;
+		if( !generator.IsValid() )
+			return false;
+
+		if( !group->ExtendOrbit( generator ) )
+			return false;
+	}
+
+	bool trivial = false;
+	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
+		if( !group->SiftIn( *iter, trivial ) )
+			return false;
+
+	PermutationProductReplacementStream randomStream( &generatorSet, randomSeed );
+	Permutation element;
+
+	uint siftCount = 0;
+	uint trivialSiftCount = 0;
+	while( trivialSiftCount < randomSiftLimit )
+	{
+		if( !knownOrder.IsZero() )
+		{
+			int comparison = group->Order().Compare( knownOrder );
+			if( comparison == 0 )
+				break;
+
+			// The chain can't describe a bigger group than the one it's made from.
+			if( comparison > 0 )
+				return false;
+		}
+
+		randomStream.OutputPermutation( element );
+		if( !group->SiftIn( element, trivial ) )
+			return false;
+
+		trivialSiftCount = trivial ? ( trivialSiftCount + 1 ) : 0;
+		siftCount++;
+	}
+
+	if( logStream )
+		*logStream << "Sifted " << siftCount << " random elements to reach order " << group->Order().ToString() << ".\n";
+
+	// If the order is known and hasn't been reached, the chain is certainly missing something.
+	if( verifyRandomChain || ( !knownOrder.IsZero() && group->Order() != knownOrder ) )
+	{
+		if( !CompleteDeterministically() )
+			return false;
+
+		if( logStream )
+			*logStream << "Completed deterministically to reach order " << group->Order().ToString() << ".\n";
+	}
+
+	if( !knownOrder.IsZero() && group->Order() != knownOrder )
+		return false;
+
+	return FinishGeneration();
+}
+
+// The groups are visited from the bottom of the chain up, so that each one's sub-group is
+// already complete by the time its Schreier generators are put into it.  Anything that's
+// missing is then added by the deterministic algorithm, which also completes what's below it.
+bool StabilizerChain::CompleteDeterministically( void )
+{
+	std::vector< Group* > groupArray;
+	for( Group* subGroup = group; subGroup; subGroup = subGroup->subGroup )
+		groupArray.push_back( subGroup );
+
+	for( uint i = ( uint )groupArray.size(); i > 0; i-- )
+		if( !groupArray[ i - 1 ]->ExtendWithSchreierGenerators() )
+			return false;
+
+	return true;
+}
+
+// The orbit trees are only needed while the chain is being made, and any groups left with a
+// trivial orbit are folded into the groups below them.
+bool StabilizerChain::FinishGeneration( void )
+{
+	delete threadPool;
+	threadPool = nullptr;
+
 	Group* subGroup = group;
 	while( subGroup )
 	{
 		delete subGroup->rootNode;
 		subGroup->rootNode = nullptr;
+		subGroup->filterMap.clear();
 		subGroup = subGroup->subGroup;
 	}
 
@@ -186,7 +455,7 @@ bool StabilizerChain::Generate( const PermutationSet& generatorSet, const UintAr
 	while( true )
 	{
 		subGroup = group;
-		while( subGroup && subGroup->transversalSet.size() != 1 )
+		while( subGroup && subGroup->TransversalSize() != 1 )
 			subGroup = subGroup->subGroup;
 
 		if( !subGroup || subGroup == group )
@@ -213,6 +482,8 @@ void StabilizerChain::Print( std::ostream& ostream ) const
 	ostream << "===============================================\n";
 }
 
+/*static*/ const uint StabilizerChain::Group::invalidKeyPoint;
+
 StabilizerChain::Group::Group( StabilizerChain* stabChain, Group* superGroup, uint stabilizerOffset )
 {
 	this->stabChain = stabChain;
@@ -220,12 +491,15 @@ StabilizerChain::Group::Group( StabilizerChain* stabChain, Group* superGroup, ui
 	subGroup = nullptr;
 	this->superGroup = superGroup;
 	rootNode = nullptr;
+	schreierVector = nullptr;
+	cosetKeyPoint = invalidKeyPoint;
 }
 
 /*virtual*/ StabilizerChain::Group::~Group( void )
 {
 	delete subGroup;
 	delete rootNode;
+	delete schreierVector;
 }
 
 void StabilizerChain::Group::Print( std::ostream& ostream ) const
@@ -240,10 +514,15 @@ void StabilizerChain::Group::Print( std::ostream& ostream ) const
 	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
 		( *iter ).Print( ostream );
 
-	ostream << "Transversal set:\n";
+	if( schreierVector )
+		schreierVector->Print( ostream );
+	else
+	{
+		ostream << "Transversal set:\n";
 
-	for( PermutationSet::const_iterator iter = transversalSet.cbegin(); iter != transversalSet.cend(); iter++ )
-		( *iter ).Print( ostream );
+		for( PermutationSet::const_iterator iter = transversalSet.cbegin(); iter != transversalSet.cend(); iter++ )
+			( *iter ).Print( ostream );
+	}
 
 	if( subGroup )
 		subGroup->Print( ostream );
@@ -259,10 +538,14 @@ bool StabilizerChain::Group::Eliminate( void )
 	if( !subGroup )
 		return false;
 
+	// A Schreier vector's representatives can't be folded into the sub-group, so this only
+	// goes ahead when there's nothing to fold in, which is when the chain calls it anyway.
+	if( schreierVector && schreierVector->OrbitSize() != 1 )
+		return false;
+
 	const NaturalNumberSet& sourcePointSet = GetSubgroupStabilizerPointSet();
 	NaturalNumberSet& destinationPointSet = stabChain->baseArray[ subGroup->stabilizerOffset ];
-	for( NaturalNumberSet::UintSet::const_iterator iter = sourcePointSet.set.cbegin(); iter != sourcePointSet.set.cend(); iter++ )
-		destinationPointSet.AddMember( *iter );
+	destinationPointSet.Copy( sourcePointSet, false );
 
 	std::vector< const Permutation* > permutationArray;
 
@@ -272,22 +555,41 @@ bool StabilizerChain::Group::Eliminate( void )
 		permutationArray.push_back( permutation );
 	}
 
+	// Every element of the sub-group's transversal gets multiplied by the same permutation
+	// at once, so they are laid out together in a batch, if there's anything to multiply.
+	PermutationBatch permutationBatch;
+	PermutationBatch productBatch;
+	Permutation product;
+
 	for( PermutationSet::iterator iter = transversalSet.begin(); iter != transversalSet.end(); iter++ )
 	{
 		const Permutation& permutation = *iter;
 		if( permutation.IsIdentity() )
 			continue;
 
+		if( permutationBatch.Count() == 0 )
+		{
+			permutationBatch.SetDegree( std::max( PermutationBatch::Degree( subGroup->transversalSet ), PermutationBatch::Degree( transversalSet ) ) );
+			for( uint i = 0; i < permutationArray.size(); i++ )
+				permutationBatch.Add( *permutationArray[i] );
+		}
+
+		if( !productBatch.ComposeWithOne( permutationBatch, permutation ) )
+			return false;
+
 		for( uint i = 0; i < permutationArray.size(); i++ )
 		{
-			Permutation product;
-			product.Multiply( *permutationArray[i], permutation );
+			productBatch.Get( i, product );
+			Permutation::MultiplyWords( product, { { permutationArray[i], false }, { &permutation, false } } );
 
 			// This should always increase the size of the set.
-			subGroup->transversalSet.insert( product );
+			subGroup->transversalSet.insert( std::move( product ) );
 		}
 	}
 
+	// The sub-group now stabilizes more points, and may have more representatives.
+	subGroup->IndexTransversalSet();
+
 	if( !superGroup )
 	{
 		stabChain->group = subGroup;
@@ -303,18 +605,83 @@ bool StabilizerChain::Group::Eliminate( void )
 	return true;
 }
 
-// Note: Here we're limited to integer arithematic mod 2^64, which is not sufficient
-//       to calculate the order of the Rubik's Cube group!
-unsigned long long StabilizerChain::Group::Order( void ) const
+// The order is the product of the transversal sizes down the chain, which is worked out
+// exactly, since it's often too big for 64 bits, as it is for the Rubik's Cube group.
+BigUint StabilizerChain::Group::Order( void ) const
 {
-	unsigned long long subGroupIndex = transversalSet.size();
-	unsigned long long subGroupOrder = 1;
-	if( subGroup )
-		subGroupOrder = subGroup->Order();
-	unsigned long long groupOrder = subGroupIndex * subGroupOrder;
+	BigUint groupOrder(1);
+	for( const Group* group = this; group; group = group->subGroup )
+		groupOrder.MultiplyBy( group->TransversalSize() );
 	return groupOrder;
 }
 
+uint StabilizerChain::Group::TransversalSize( void ) const
+{
+	if( schreierVector )
+		return schreierVector->OrbitSize();
+
+	return ( uint )transversalSet.size();
+}
+
+void StabilizerChain::Group::MaterializeTransversal( void )
+{
+	if( !schreierVector )
+		return;
+
+	schreierVector->GetRepresentativeSet( transversalSet );
+	delete schreierVector;
+	schreierVector = nullptr;
+
+	IndexTransversalSet();
+}
+
+// The key point is the first stabilizer point that no two representatives take to the same
+// place.  There's always one in a chain made by Schreier-Sims, but if there isn't, say in a
+// chain loaded from elsewhere, the transversal set goes unindexed and is searched instead.
+void StabilizerChain::Group::IndexTransversalSet( void )
+{
+	cosetKeyPoint = invalidKeyPoint;
+	cosetHandleArray.clear();
+
+	if( stabilizerOffset >= stabChain->baseArray.size() )
+		return;
+
+	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
+	for( NaturalNumberSet::const_iterator pointIter = stabilizerPointSet.cbegin(); pointIter != stabilizerPointSet.cend(); pointIter++ )
+	{
+		cosetKeyPoint = *pointIter;
+
+		PermutationSet::iterator iter = transversalSet.begin();
+		while( iter != transversalSet.end() && IndexCosetRepresentative( iter.handle ) )
+			iter++;
+
+		if( iter == transversalSet.end() )
+			return;
+	}
+}
+
+// This fails, and drops the index, if another representative already takes the key point
+// to the same place as the given one.
+bool StabilizerChain::Group::IndexCosetRepresentative( PermutationSet::Handle handle )
+{
+	if( cosetKeyPoint == invalidKeyPoint )
+		return false;
+
+	uint image = transversalSet.Get( handle ).Evaluate( cosetKeyPoint );
+	if( image >= cosetHandleArray.size() )
+		cosetHandleArray.resize( image + 1, PermutationSet::Handle( PermutationSet::nullHandle ) );
+
+	if( cosetHandleArray[ image ] != PermutationSet::nullHandle && cosetHandleArray[ image ] != handle )
+	{
+		cosetKeyPoint = invalidKeyPoint;
+		cosetHandleArray.clear();
+		return false;
+	}
+
+	cosetHandleArray[ image ] = handle;
+	return true;
+}
+
 bool StabilizerChain::Group::Extend( const Permutation& generator, bool* extended /*= nullptr*/ )
 {
 	if( extended )
@@ -323,9 +690,6 @@ bool StabilizerChain::Group::Extend( const Permutation& generator, bool* extende
 	if( IsMember( generator ) )
 		return true;
 
-	if( extended )
-		*extended = true;
-
 	std::ostream* logStream = stabChain->logStream;
 
 	if( logStream )
@@ -334,95 +698,503 @@ bool StabilizerChain::Group::Extend( const Permutation& generator, bool* extende
 		//generator.Print( *logStream );
 	}
 
-	generatorSet.insert( generator );
+	const Permutation* addedGenerator = nullptr;
+	if( !AddGenerator( generator, addedGenerator ) )
+		return true;
+
+	if( extended )
+		*extended = true;
+
+	const Permutation& newGenerator = *addedGenerator;
+
+	// The pairs and the new orbit nodes only last as long as this call, so they're made in
+	// the thread's scratch arena, which is wound back to where it was when the call returns.
+	ScratchArena::Scope scratchScope;
 
-	PermutationSet singletonSet;
-	singletonSet.insert( generator );
+	if( schreierVector || ( stabChain->useSchreierVectors && transversalSet.size() == 0 ) )
+		return ExtendSchreierVector( newGenerator );
 
 	bool fresh = false;
 	if( !rootNode )
 	{
-		const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
-		if( !stabilizerPointSet.Cardinality() == 1 )
+		if( !MakeRootNode( newGenerator.map.Size() ) )
 			return false;
 
-		// The root of the orbit tree must be the identity to satisfy a requirement of Schreier's lemma.
-		Permutation identity;
-		transversalSet.insert( identity );
-		PermutationSet::iterator iter = transversalSet.find( identity );
-		rootNode = new OrbitNode( &( *iter ) );
-		orbitSet.AddMember( *stabilizerPointSet.set.begin() );
 		fresh = true;
 	}
 
-	struct Pair
-	{
-		const Permutation* cosetRepresentative;
-		const Permutation* generator;
-	};
-
-	typedef std::list< Pair > PairList;
-	PairList pairList;
+	ScratchSchreierPairArray pairArray;
+	pairArray.reserve( transversalSet.size() );
 
 	for( PermutationSet::iterator iter = transversalSet.begin(); iter != transversalSet.end(); iter++ )
 	{
-		Pair pair;
+		SchreierPair pair;
 		pair.cosetRepresentative = &( *iter );
-		pair.generator = &generator;
-		pairList.push_back( pair );
+		pair.generator = &newGenerator;
+		pair.imageRepresentative = nullptr;
+		pair.state = SchreierPair::StateUnknown;
+		pairArray.push_back( pair );
 	}
 
-	OrbitNodeArray newOrbitArray;
-	if( !rootNode->Grow( this, generatorSet, singletonSet, fresh, newOrbitArray ) )
+	ScratchOrbitNodeArray newOrbitArray;
+	if( !rootNode->Grow( this, generatorSet, newGenerator, fresh, newOrbitArray ) )
 		return false;
 
 	for( uint i = 0; i < newOrbitArray.size(); i++ )
 	{
-		const Permutation* cosetRepresentative = newOrbitArray[i]->cosetRepresentative;
+		const Permutation* cosetRepresentative = &transversalSet.Get( newOrbitArray[i]->cosetHandle );
 		for( PermutationSet::iterator genIter = generatorSet.begin(); genIter != generatorSet.end(); genIter++ )
 		{
-			Pair pair;
+			SchreierPair pair;
 			pair.generator = &( *genIter );
 			pair.cosetRepresentative = cosetRepresentative;
-			pairList.push_back( pair );
+			pair.imageRepresentative = nullptr;
+			pair.state = SchreierPair::StateUnknown;
+			pairArray.push_back( pair );
 		}
 	}
 
-	for( PairList::iterator pairIter = pairList.begin(); pairIter != pairList.end(); pairIter++ )
-	{
-		Pair& pair = *pairIter;
-		const Permutation& cosetRepresentative = *pair.cosetRepresentative;
-		const Permutation& generator = *pair.generator;
+	return ExtendSubGroup( pairArray );
+}
 
-		Permutation product;
-		product.Multiply( cosetRepresentative, generator );
+// This is the same as the above, but with the orbit kept in a Schreier vector.  The Schreier
+// generators are made from the same pairs of orbit points and generators, but the coset
+// representatives of both points in each pair are made as they're needed.
+bool StabilizerChain::Group::ExtendSchreierVector( const Permutation& generator )
+{
+	if( !schreierVector && !MakeSchreierVector() )
+		return false;
 
-		PermutationSet::iterator iter = FindCoset( product );
-		if( iter == transversalSet.end() )
-			return false;		// Something went wrong with our math!
+	uint oldOrbitSize = schreierVector->OrbitSize();
+	uint generatorIndex = schreierVector->AddGenerator( generator );
+
+	std::ostream* logStream = stabChain->logStream;
+	if( logStream && schreierVector->OrbitSize() > oldOrbitSize )
+		*logStream << "Found " << ( schreierVector->OrbitSize() - oldOrbitSize ) << " new orbit points.\n";
 
-		Permutation invCosetRepresentative;
-		invCosetRepresentative.SetInverse( *iter );
+	// These are reused across the loop so that their storage is only ever allocated once.
+	Permutation cosetRepresentative;
+	Permutation imageRepresentative;
+	Permutation schreierGenerator;
 
-		Permutation schreierGenerator;
-		schreierGenerator.Multiply( product, invCosetRepresentative );
+	for( uint i = 0; i < schreierVector->OrbitSize(); i++ )
+	{
+		uint point = schreierVector->orbitArray[i];
+		schreierVector->GetRepresentative( point, cosetRepresentative );
 
-		if( !schreierGenerator.IsIdentity() )
+		// The points that were already in the orbit have been paired with every generator but the new one.
+		uint firstGeneratorIndex = ( i < oldOrbitSize ) ? generatorIndex : 0;
+		for( uint j = firstGeneratorIndex; j <= generatorIndex; j++ )
 		{
-			if( stabilizerOffset >= stabChain->baseArray.size() )
+			const Permutation& generator = schreierVector->generatorArray[j];
+			if( !schreierVector->GetRepresentative( generator.Evaluate( point ), imageRepresentative ) )
+				return false;		// Something went wrong with our math!
+
+			if( !ExtendSubGroup( cosetRepresentative, generator, imageRepresentative, schreierGenerator ) )
 				return false;
+		}
+	}
+
+	return true;
+}
+
+// The Schreier generator of a pair is the coset representative, then the generator, then the
+// inverse of the representative of the coset that lands in.  It's often the identity, so it's
+// only multiplied out once it's known not to be.  Until then, it's only ever looked at point
+// by point.  The given permutation is only where it's written, so its storage can be reused.
+bool StabilizerChain::Group::ExtendSubGroup( const Permutation& cosetRepresentative, const Permutation& generator, const Permutation& imageRepresentative, Permutation& schreierGenerator )
+{
+	if( ( cosetRepresentative * generator * Inverse( imageRepresentative ) ).IsIdentity() )
+		return true;
+
+	( cosetRepresentative * generator * Inverse( imageRepresentative ) ).GetPermutation( schreierGenerator );
+
+	if( stabilizerOffset >= stabChain->baseArray.size() )
+		return false;
+
+	if( !subGroup )
+	{
+		// The Schreier generator fixes every base point so far, so if the base has run out,
+		// it's extended by a point the generator moves, just as it is when sifting.
+		if( stabilizerOffset + 1 >= stabChain->baseArray.size() )
+		{
+			NaturalNumberSet unstableSet;
+			schreierGenerator.GetUnstableSet( unstableSet );
+
+			NaturalNumberSet singletonSet;
+			singletonSet.AddMember( unstableSet.Min() );
+			stabChain->baseArray.push_back( singletonSet );
+		}
+
+		subGroup = new Group( stabChain, this, stabilizerOffset + 1 );
+	}
+
+	// The same Schreier generator often comes up more than once, and if it was kept the first
+	// time, a hash look-up is enough to see that it needn't be sifted again.
+	if( subGroup->generatorSet.find( schreierGenerator ) != subGroup->generatorSet.cend() )
+		return true;
+
+	return subGroup->Extend( schreierGenerator );
+}
+
+// The pairs are gone through in order, and the sub-group is extended by each of their Schreier
+// generators.  With a thread pool, this is done a batch of pairs at a time.  The threads first
+// sift the batch against the chain below as it stands, which they only read, and then this
+// thread extends the sub-group with whatever didn't sift to the identity, in order.  Anything
+// that sifted to the identity is still in the sub-group once it has grown, so would only have
+// been sifted to the identity again.  The candidates are sifted again before they're added,
+// since the sub-group may have grown to take them in by then.  So the chain comes out just as
+// it would have if every pair had been gone through by this thread alone.
+bool StabilizerChain::Group::ExtendSubGroup( ScratchSchreierPairArray& pairArray )
+{
+	// This is reused across the loop so that its storage is only ever allocated once.
+	Permutation schreierGenerator;
+
+	ThreadPool* threadPool = stabChain->threadPool;
+	if( stabilizerOffset >= stabChain->baseArray.size() )
+		threadPool = nullptr;
+
+	uint batchSize = threadPool ? threadPool->ThreadCount() * schreierPairsPerThread : ( uint )pairArray.size();
+	for( uint i = 0; i < pairArray.size(); i += batchSize )
+	{
+		uint batchEnd = std::min( i + batchSize, ( uint )pairArray.size() );
+
+		if( threadPool && batchEnd - i > 1 )
+		{
+			SetShared( true );
+			SchreierPairSifter sifter( this, &pairArray[i] );
+			threadPool->Run( sifter, batchEnd - i );
+			SetShared( false );
+		}
+
+		for( uint j = i; j < batchEnd; j++ )
+		{
+			SchreierPair& pair = pairArray[j];
+
+			if( pair.state == SchreierPair::StateUnknown )
+			{
+				PermutationSet::iterator iter = FindCoset( *pair.cosetRepresentative * *pair.generator );
+				if( iter == transversalSet.end() )
+					return false;		// Something went wrong with our math!
+
+				pair.imageRepresentative = &( *iter );
+				pair.state = SchreierPair::StateCandidate;
+			}
+
+			if( pair.state == SchreierPair::StateFailed )
+				return false;		// Something went wrong with our math!
+
+			if( pair.state == SchreierPair::StateCandidate )
+				if( !ExtendSubGroup( *pair.cosetRepresentative, *pair.generator, *pair.imageRepresentative, schreierGenerator ) )
+					return false;
+		}
+	}
+
+	return true;
+}
+
+// This is the part of extending the sub-group by a pair's Schreier generator that only reads the
+// chain, and it can be done by any number of threads at once while the chain is shared.
+void StabilizerChain::Group::SiftSchreierPair( SchreierPair& pair, Permutation& schreierGenerator ) const
+{
+	PermutationSet::iterator iter = const_cast< Group* >( this )->FindCoset( *pair.cosetRepresentative * *pair.generator );
+	if( iter == transversalSet.end() )
+	{
+		pair.state = SchreierPair::StateFailed;
+		return;
+	}
 
-			if( !subGroup )
-				subGroup = new Group( stabChain, this, stabilizerOffset + 1 );
+	pair.imageRepresentative = &( *iter );
 
-			if( !subGroup->Extend( schreierGenerator ) )
+	if( ( *pair.cosetRepresentative * *pair.generator * Inverse( *pair.imageRepresentative ) ).IsIdentity() )
+	{
+		pair.state = SchreierPair::StateTrivial;
+		return;
+	}
+
+	pair.state = SchreierPair::StateCandidate;
+
+	if( !subGroup )
+		return;
+
+	( *pair.cosetRepresentative * *pair.generator * Inverse( *pair.imageRepresentative ) ).GetPermutation( schreierGenerator );
+
+	if( subGroup->generatorSet.find( schreierGenerator ) != subGroup->generatorSet.cend() || subGroup->IsMember( schreierGenerator ) )
+		pair.state = SchreierPair::StateTrivial;
+}
+
+// Permutations work out their hashes and moved points when they're first asked for them, and
+// the Schreier vectors cache the representatives they make.  So before the chain is shared,
+// all of that is worked out up front for this group and those below it, and the caches are
+// frozen.  Nothing that sifting reads is then written until the chain is no longer shared.
+void StabilizerChain::Group::SetShared( bool shared )
+{
+	for( Group* group = this; group; group = group->subGroup )
+	{
+		if( shared )
+		{
+			const PermutationSet* permutationSetArray[] = { &group->generatorSet, &group->transversalSet };
+			for( uint i = 0; i < 2; i++ )
+			{
+				const PermutationSet& permutationSet = *permutationSetArray[i];
+				for( PermutationSet::const_iterator iter = permutationSet.cbegin(); iter != permutationSet.cend(); iter++ )
+				{
+					iter->CalcHash();
+					iter->IsSparse();
+				}
+			}
+		}
+
+		if( group->schreierVector )
+			group->schreierVector->SetCacheFrozen( shared );
+	}
+}
+
+// Every pair of a coset representative and a generator gives a Schreier generator, and this
+// puts all of them into the sub-group, not just those of a new generator, as Extend does.
+bool StabilizerChain::Group::ExtendWithSchreierGenerators( void )
+{
+	Permutation schreierGenerator;
+
+	if( schreierVector )
+	{
+		Permutation cosetRepresentative;
+		Permutation imageRepresentative;
+
+		for( uint i = 0; i < schreierVector->OrbitSize(); i++ )
+		{
+			uint point = schreierVector->orbitArray[i];
+			schreierVector->GetRepresentative( point, cosetRepresentative );
+
+			for( uint j = 0; j < schreierVector->generatorArray.size(); j++ )
+			{
+				const Permutation& generator = schreierVector->generatorArray[j];
+				if( !schreierVector->GetRepresentative( generator.Evaluate( point ), imageRepresentative ) )
+					return false;
+
+				if( !ExtendSubGroup( cosetRepresentative, generator, imageRepresentative, schreierGenerator ) )
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	ScratchArena::Scope scratchScope;
+	ScratchSchreierPairArray pairArray;
+	pairArray.reserve( transversalSet.size() * generatorSet.size() );
+
+	for( PermutationSet::iterator iter = transversalSet.begin(); iter != transversalSet.end(); iter++ )
+	{
+		for( PermutationSet::iterator genIter = generatorSet.begin(); genIter != generatorSet.end(); genIter++ )
+		{
+			SchreierPair pair;
+			pair.cosetRepresentative = &( *iter );
+			pair.generator = &( *genIter );
+			pair.imageRepresentative = nullptr;
+			pair.state = SchreierPair::StateUnknown;
+			pairArray.push_back( pair );
+		}
+	}
+
+	return ExtendSubGroup( pairArray );
+}
+
+// The generator is added, and the orbit grown under it, but no Schreier generators are made.
+bool StabilizerChain::Group::ExtendOrbit( const Permutation& generator )
+{
+	const Permutation* addedGenerator = nullptr;
+	if( !AddGenerator( generator, addedGenerator ) )
+		return true;
+
+	const Permutation& newGenerator = *addedGenerator;
+
+	if( schreierVector || ( stabChain->useSchreierVectors && transversalSet.size() == 0 ) )
+	{
+		if( !schreierVector && !MakeSchreierVector() )
+			return false;
+
+		schreierVector->AddGenerator( newGenerator );
+		return true;
+	}
+
+	bool fresh = false;
+	if( !rootNode )
+	{
+		if( !MakeRootNode( newGenerator.map.Size() ) )
+			return false;
+
+		fresh = true;
+	}
+
+	ScratchArena::Scope scratchScope;
+	ScratchOrbitNodeArray newOrbitArray;
+	return rootNode->Grow( this, generatorSet, newGenerator, fresh, newOrbitArray );
+}
+
+// The top group keeps the generators it's given, words and all, but below it each generator
+// is put through Sims' filter first.  This gives back the generator as it was kept, and fails
+// if it wasn't, because it's already generated by those that were, or it's already one of them.
+bool StabilizerChain::Group::AddGenerator( const Permutation& generator, const Permutation*& addedGenerator )
+{
+	if( !superGroup )
+	{
+		std::pair< PermutationSet::iterator, bool > result = generatorSet.insert( generator );
+		addedGenerator = &( *result.first );
+		return result.second;
+	}
+
+	Permutation filteredGenerator;
+	filteredGenerator.SetCopy( generator );
+
+	uint64_t filterKey = 0;
+	if( !FilterGenerator( filteredGenerator, filterKey ) )
+		return false;
+
+	std::pair< PermutationSet::iterator, bool > result = generatorSet.insert( std::move( filteredGenerator ) );
+	if( !result.second )
+		return false;
+
+	filterMap[ filterKey ] = result.first.handle;
+	addedGenerator = &( *result.first );
+	return true;
+}
+
+// This is Sims' filter.  Every kept generator fixes every point before its first moved point,
+// and no two of them move that point to the same place.  So if one agrees with the given
+// generator on its first moved point, the given one can be divided by it, and then fixes that
+// point too.  This goes on until the generator is the identity, and so is generated by those
+// kept, or until no kept generator agrees with it, and it can be kept itself.  There's then
+// at most one generator kept for every point and image, however many are offered.
+bool StabilizerChain::Group::FilterGenerator( Permutation& generator, uint64_t& filterKey ) const
+{
+	uint point = 0;
+	while( true )
+	{
+		while( point < generator.map.Size() && generator.map[ point ] == point )
+			point++;
+
+		if( point >= generator.map.Size() )
+			return false;
+
+		filterKey = ( uint64_t( point ) << 32 ) | generator.map[ point ];
+
+		FilterMap::const_iterator iter = filterMap.find( filterKey );
+		if( iter == filterMap.end() )
+			return true;
+
+		if( !generator.MultiplyInverse( generator, generatorSet.Get( iter->second ) ) )
+			return false;
+
+		point++;
+	}
+}
+
+// The element, which must be in the group, is sifted down the chain, by dividing out the
+// coset representative it picks out at each level.  If it comes out the other end as the
+// identity, it was already in the group the chain describes, and the chain is left as it is.
+// Otherwise, what's left of it is added as a generator to every group it's in, below this one,
+// down to the one it dropped out at.  If that's beyond the bottom of the chain, new groups are
+// added for it, along with a base point it moves, if the base has run out.
+bool StabilizerChain::Group::SiftIn( const Permutation& element, bool& trivial )
+{
+	trivial = false;
+
+	Permutation residue;
+	residue.SetCopy( element, false );
+
+	Permutation representative;
+	Group* lastGroup = nullptr;
+	Group* dropGroup = this;
+	while( dropGroup )
+	{
+		if( !residue.Stabilizes( dropGroup->GetSubgroupStabilizerPointSet() ) )
+		{
+			const Permutation* cosetRepresentative = dropGroup->FindCosetRepresentative( residue, representative );
+			if( !cosetRepresentative )
+				break;
+
+			if( !residue.MultiplyInverse( residue, *cosetRepresentative ) )
 				return false;
 		}
+
+		lastGroup = dropGroup;
+		dropGroup = dropGroup->subGroup;
+	}
+
+	if( dropGroup == this )
+		return false;		// Something went wrong with our math!
+
+	if( !dropGroup )
+	{
+		if( residue.IsIdentity() )
+		{
+			trivial = true;
+			return true;
+		}
+
+		// The groups added for any base points the residue fixes have trivial orbits, and are
+		// eliminated once the chain is finished.
+		while( true )
+		{
+			uint stabilizerOffset = lastGroup->stabilizerOffset + 1;
+			if( stabilizerOffset >= stabChain->baseArray.size() )
+			{
+				NaturalNumberSet unstableSet;
+				residue.GetUnstableSet( unstableSet );
+
+				NaturalNumberSet singletonSet;
+				singletonSet.AddMember( unstableSet.Min() );
+				stabChain->baseArray.push_back( singletonSet );
+			}
+
+			lastGroup->subGroup = new Group( stabChain, lastGroup, stabilizerOffset );
+			lastGroup = lastGroup->subGroup;
+
+			if( !residue.Stabilizes( lastGroup->GetSubgroupStabilizerPointSet() ) )
+				break;
+		}
+
+		dropGroup = lastGroup;
+	}
+
+	for( Group* group = subGroup; group; group = group->subGroup )
+	{
+		if( !group->ExtendOrbit( residue ) )
+			return false;
+
+		if( group == dropGroup )
+			break;
 	}
 
 	return true;
 }
 
+bool StabilizerChain::Group::MakeRootNode( uint degree )
+{
+	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
+	if( stabilizerPointSet.Cardinality() != 1 )
+		return false;
+
+	// The root of the orbit tree must be the identity to satisfy a requirement of Schreier's lemma.
+	PermutationSet::iterator iter = transversalSet.emplace().first;
+	rootNode = new OrbitNode( iter.handle );
+	orbitSet.Reserve( degree );
+	orbitSet.AddMember( stabilizerPointSet.Min() );
+	IndexTransversalSet();
+	return true;
+}
+
+bool StabilizerChain::Group::MakeSchreierVector( void )
+{
+	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
+	if( stabilizerPointSet.Cardinality() != 1 )
+		return false;
+
+	schreierVector = new SchreierVector( stabilizerPointSet.Min(), stabChain->representativeCacheSize );
+	return true;
+}
+
 bool StabilizerChain::Group::StabilizesPoint( uint point ) const
 {
 	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
@@ -437,26 +1209,31 @@ bool StabilizerChain::Group::StabilizesPoint( uint point ) const
 
 PermutationSet::iterator StabilizerChain::Group::FindCoset( const Permutation& permutation )
 {
-	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
-
-	Permutation invPermutation;
-	invPermutation.SetInverse( permutation );
+	return FindCoset( PermutationTerm( permutation ) );
+}
 
-	PermutationSet::iterator iter = transversalSet.begin();
-	while( iter != transversalSet.end() )
+// The representative is either found in the transversal set, or made in the given permutation
+// from the Schreier vector, and in both cases a pointer to it is returned.  The Schreier vector
+// only knows about its root point, so if there are more stabilizer points, as there are once a
+// level above has been eliminated, the representative is checked against the rest of them too.
+const Permutation* StabilizerChain::Group::FindCosetRepresentative( const Permutation& permutation, Permutation& representative ) const
+{
+	if( !schreierVector )
 	{
-		const Permutation& cosetRepresentative = *iter;
+		PermutationSet::iterator iter = const_cast< Group* >( this )->FindCoset( permutation );
+		if( iter == transversalSet.end() )
+			return nullptr;
 
-		Permutation product;
-		product.Multiply( cosetRepresentative, invPermutation );
+		return &( *iter );
+	}
 
-		if( product.Stabilizes( stabilizerPointSet ) )
-			break;
+	if( !schreierVector->GetRepresentative( permutation.Evaluate( schreierVector->rootPoint ), representative ) )
+		return nullptr;
 
-		iter++;
-	}
+	if( !( representative * Inverse( permutation ) ).Stabilizes( GetSubgroupStabilizerPointSet() ) )
+		return nullptr;
 
-	return iter;
+	return &representative;
 }
 
 // Assuming that the stabilizer chain rooted as this node is valid, tell
@@ -483,19 +1260,19 @@ bool StabilizerChain::Group::FactorInverse( const Permutation& permutation, Perm
 		return subGroup->FactorInverse( permutation, invPermutation );
 	}
 
-	PermutationSet::iterator iter = const_cast< Group* >( this )->FindCoset( permutation );
-	if( iter == transversalSet.end() )
+	Permutation representative;
+	const Permutation* cosetRepresentativePtr = FindCosetRepresentative( permutation, representative );
+	if( !cosetRepresentativePtr )
 		return false;
 
-	const Permutation& cosetRepresentative = *iter;
-
-	Permutation invCosetRepresentative;
-	cosetRepresentative.GetInverse( invCosetRepresentative );
+	const Permutation& cosetRepresentative = *cosetRepresentativePtr;
 
 	Permutation product;
-	product.Multiply( permutation, invCosetRepresentative );
+	if( !product.MultiplyInverse( permutation, cosetRepresentative ) )
+		return false;
 
-	invPermutation.MultiplyOnRight( invCosetRepresentative );
+	if( !invPermutation.MultiplyInverse( invPermutation, cosetRepresentative ) )
+		return false;
 
 	return FactorInverse( product, invPermutation );
 }
@@ -516,24 +1293,24 @@ bool StabilizerChain::Group::FactorInverseWithTrembling( const Permutation& perm
 		for( PermutationSet::const_iterator iter = trembleSet.cbegin(); iter != trembleSet.cend(); iter++ )
 		{
 			const Permutation& trembler = *iter;
-			if( !trembler.word )
+			if( !trembler.HasWord() )
 				return false;
 
 			Permutation product;
 			product.Multiply( permutation, trembler );
 
 			Permutation invProduct;
-			invProduct.word = std::make_unique<ElementList>();
+			invProduct.word = std::make_unique<ElementArray>();
 			if( !FactorInverse( product, invProduct ) )
 				return false;
 
 			Permutation altInvPermutation;
-			altInvPermutation.word = std::make_unique<ElementList>();
+			altInvPermutation.word = std::make_unique<ElementArray>();
 			altInvPermutation.Multiply( trembler, invProduct );
 
 			altInvPermutation.CompressWord( compressInfo );
 
-			if( altInvPermutation.word->size() < invPermutation.word->size() )
+			if( altInvPermutation.WordLength() < invPermutation.WordLength() )
 			{
 				optimizationMade = true;
 				altInvPermutation.GetCopy( invPermutation );
@@ -556,18 +1333,19 @@ void StabilizerChain::Group::NameGenerators( void )
 		PermutationSet::iterator nextIter = iter;
 		nextIter++;
 
-		Permutation permutation = *iter;
-		if( !permutation.word )
+		if( !iter->HasWord() )
 		{
 			Element element;
-			element.name = name++;
+			element.id = GeneratorAlphabet::Intern( std::string( 1, name++ ) );
 			element.exponent = 1;
 
-			permutation.word = std::make_unique<ElementList>();
+			// Naming a generator doesn't change its hash, so its node can be taken out,
+			// named, and put back, without copying it.
+			PermutationSet::node_type node = generatorSet.extract( iter );
+			Permutation& permutation = node.value();
+			permutation.word = std::make_unique<ElementArray>();
 			permutation.word->push_back( element );
-
-			generatorSet.erase( iter );
-			generatorSet.insert( permutation );
+			generatorSet.insert( std::move( node ) );
 		}
 
 		iter = nextIter;
@@ -577,8 +1355,7 @@ void StabilizerChain::Group::NameGenerators( void )
 bool StabilizerChain::Group::MakeCompressInfo( CompressInfo& compressInfo )
 {
 	compressInfo.permutationMap.clear();
-	compressInfo.commuteMap.clear();
-	compressInfo.orderMap.clear();
+	compressInfo.built = false;
 
 	for( PermutationSet::iterator iter = generatorSet.begin(); iter != generatorSet.end(); iter++ )
 	{
@@ -589,9 +1366,11 @@ bool StabilizerChain::Group::MakeCompressInfo( CompressInfo& compressInfo )
 
 		const Element& element = *generator.word->begin();
 
-		compressInfo.permutationMap.insert( std::pair< std::string, Permutation >( element.name, generator ) );
+		compressInfo.permutationMap.insert( std::pair< std::string, Permutation >( GeneratorAlphabet::Name( element.id ), generator ) );
 	}
 
+	// The order and commutation tables are made once here, rather than on first use.
+	compressInfo.Build();
 	return true;
 }
 
@@ -638,8 +1417,13 @@ bool StabilizerChain::Group::SaveRecursive( rapidjson::Value& chainGroupValue, r
 
 	chainGroupValue.AddMember( "generators", generatorsValue, allocator );
 
+	// A Schreier vector is saved as the transversal set it stands for, so that it loads as one.
+	PermutationSet materializedSet;
+	if( schreierVector )
+		schreierVector->GetRepresentativeSet( materializedSet );
+
 	rapidjson::Value transversalsValue( rapidjson::kArrayType );
-	if( !Permutation::SavePermutationSet( transversalSet, transversalsValue, allocator ) )
+	if( !Permutation::SavePermutationSet( schreierVector ? materializedSet : transversalSet, transversalsValue, allocator ) )
 		return false;
 
 	chainGroupValue.AddMember( "transversals", transversalsValue, allocator );
@@ -656,6 +1440,50 @@ bool StabilizerChain::Group::SaveRecursive( rapidjson::Value& chainGroupValue, r
 	return true;
 }
 
+bool StabilizerChain::Group::LoadRecursive( PermutationDecoder& decoder )
+{
+	if( !decoder.DecodeUint( stabilizerOffset ) || stabilizerOffset >= stabChain->baseArray.size() )
+		return false;
+
+	if( !decoder.DecodePermutationSet( generatorSet ) )
+		return false;
+
+	if( !decoder.DecodePermutationSet( transversalSet ) )
+		return false;
+
+	uint8_t hasSubGroup = 0;
+	if( !decoder.DecodeByte( hasSubGroup ) )
+		return false;
+
+	IndexTransversalSet();
+
+	if( hasSubGroup )
+	{
+		subGroup = new Group( stabChain, this, 0 );
+		if( !subGroup->LoadRecursive( decoder ) )
+			return false;
+	}
+
+	return true;
+}
+
+bool StabilizerChain::Group::SaveRecursive( PermutationEncoder& encoder ) const
+{
+	PermutationSet materializedSet;
+	if( schreierVector )
+		schreierVector->GetRepresentativeSet( materializedSet );
+
+	encoder.EncodeUint( stabilizerOffset );
+	encoder.EncodePermutationSet( generatorSet );
+	encoder.EncodePermutationSet( schreierVector ? materializedSet : transversalSet );
+	encoder.EncodeByte( subGroup ? 1 : 0 );
+
+	if( subGroup )
+		return subGroup->SaveRecursive( encoder );
+
+	return true;
+}
+
 // The idea here is taken from Minkwitz, but I believe he did not have to do this as a
 // post-process of Schreier-Sims, because he already knew the order of the group.  So he
 // actually generated the chain while he was coming up with short words for the transversal
@@ -667,6 +1495,9 @@ bool StabilizerChain::Group::SaveRecursive( rapidjson::Value& chainGroupValue, r
 // length the further they are from the root.
 bool StabilizerChain::OptimizeNames( PermutationStream& permutationStream, const CompressInfo& compressInfo, OptimizeNamesCallback callback, void* callback_data /*= nullptr*/ )
 {
+	// Words can only be kept with representatives that are kept.
+	MaterializeTransversals();
+
 	Group* subGroup = group;
 	while( subGroup )
 	{
@@ -675,12 +1506,13 @@ bool StabilizerChain::OptimizeNames( PermutationStream& permutationStream, const
 		for( PermutationSet::iterator iter = subGroup->transversalSet.begin(); iter != subGroup->transversalSet.end(); iter++ )
 		{
 			const Permutation& permutation = *iter;
-			if( permutation.IsIdentity() && !permutation.word )
+			if( permutation.IsIdentity() && !permutation.HasWord() )
 			{
 				subGroup->transversalSet.erase( iter );
 				Permutation identity;
-				identity.word = std::make_unique<ElementList>();
+				identity.word = std::make_unique<ElementArray>();
 				subGroup->transversalSet.insert( identity );
+				subGroup->IndexTransversalSet();
 				break;
 			}
 		}
@@ -725,13 +1557,48 @@ bool StabilizerChain::OptimizeNames( PermutationStream& permutationStream, const
 
 bool StabilizerChain::IsCompletelyWorded( void ) const
 {
+	// A Schreier vector's representatives never have words.
+	for( const Group* subGroup = group; subGroup; subGroup = subGroup->subGroup )
+		if( subGroup->schreierVector )
+			return false;
+
 	Group* subGroup = nullptr;
 	PermutationSet::iterator iter;
 	return !const_cast< StabilizerChain* >( this )->FindUnwordedCosetRepresentative( subGroup, iter );
 }
 
+// Every coset representative with a word is checked against it, with the generator powers
+// made only once for the whole chain.  Representatives with no word are passed over.
+bool StabilizerChain::VerifyWords( const CompressInfo& compressInfo, uint* badWordCount /*= nullptr*/ ) const
+{
+	WordEvaluator wordEvaluator;
+	wordEvaluator.Build( compressInfo );
+
+	uint count = 0;
+
+	const Group* subGroup = group;
+	while( subGroup )
+	{
+		for( PermutationSet::const_iterator iter = subGroup->transversalSet.cbegin(); iter != subGroup->transversalSet.cend(); iter++ )
+		{
+			const Permutation& cosetRepresentative = *iter;
+			if( cosetRepresentative.HasWord() && !wordEvaluator.Verify( cosetRepresentative ) )
+				count++;
+		}
+
+		subGroup = subGroup->subGroup;
+	}
+
+	if( badWordCount )
+		*badWordCount = count;
+
+	return count == 0;
+}
+
 bool StabilizerChain::FindUnwordedCosetRepresentative( Group*& subGroup, PermutationSet::iterator& iter )
 {
+	MaterializeTransversals();
+
 	subGroup = this->group;
 
 	while( subGroup )
@@ -739,7 +1606,7 @@ bool StabilizerChain::FindUnwordedCosetRepresentative( Group*& subGroup, Permuta
 		for( iter = subGroup->transversalSet.begin(); iter != subGroup->transversalSet.end(); iter++ )
 		{
 			const Permutation& cosetRepresentative = *iter;
-			if( !cosetRepresentative.word )
+			if( !cosetRepresentative.HasWord() )
 				return true;
 		}
 
@@ -782,11 +1649,11 @@ bool StabilizerChain::TryToCompletePartiallyWordedChain( PermutationStream& perm
 			product.Multiply( cosetRepresentative, trembler );
 
 			Permutation invProduct;
-			invProduct.word = std::make_unique<ElementList>();
-			if( group->FactorInverse( product, invProduct ) && invProduct.word )
+			invProduct.word = std::make_unique<ElementArray>();
+			if( group->FactorInverse( product, invProduct ) && invProduct.HasWord() )
 			{
 				Permutation invCosetRepresentative;
-				invCosetRepresentative.word = std::make_unique<ElementList>();
+				invCosetRepresentative.word = std::make_unique<ElementArray>();
 
 				invCosetRepresentative.Multiply( trembler, invProduct );
 
@@ -830,9 +1697,11 @@ bool StabilizerChain::TryToCompletePartiallyWordedChain( PermutationStream& perm
 
 bool StabilizerChain::Group::OptimizeNameWithPermutation( Permutation& permutation, const CompressInfo& compressInfo )
 {
-	if( !permutation.word )
+	if( !permutation.HasWord() )
 		return false;
 
+	MaterializeTransversal();
+
 	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
 	if( permutation.Stabilizes( stabilizerPointSet ) )
 	{
@@ -850,7 +1719,11 @@ bool StabilizerChain::Group::OptimizeNameWithPermutation( Permutation& permutati
 
 	const Permutation& cosetRepresentative = *iter;
 
-	if( !cosetRepresentative.word || permutation.word->size() < cosetRepresentative.word->size() )
+	// A word held as a program is only flattened once it's a candidate for the transversal.
+	if( permutation.wordProgram )
+		permutation.CompressWord( compressInfo );
+
+	if( !cosetRepresentative.HasWord() || permutation.WordLength() < cosetRepresentative.WordLength() )
 	{
 		if( logStream )
 		{
@@ -860,16 +1733,16 @@ bool StabilizerChain::Group::OptimizeNameWithPermutation( Permutation& permutati
 			permutation.Print( *logStream );
 		}
 
-		transversalSet.erase( iter );
-		transversalSet.insert( permutation );
+		// The replaced element's node is reused for its replacement.
+		PermutationSet::node_type node = transversalSet.extract( iter );
+		node.value() = permutation;
+		transversalSet.insert( std::move( node ) );
 		return true;
 	}
 
-	Permutation invPermutation;
-	permutation.GetInverse( invPermutation );
-
 	Permutation product;
-	product.Multiply( cosetRepresentative, invPermutation );
+	if( !product.MultiplyInverse( cosetRepresentative, permutation ) )
+		return false;
 
 	product.CompressWord( compressInfo );
 
@@ -885,9 +1758,11 @@ void StabilizerChain::Stats::Reset( void )
 {
 	totalUnnamedGeneratorCount = 0;
 	totalUnnamedTransversalCount = 0;
+	totalGeneratorCount = 0;
 
 	unnamedGeneratorCountArray.clear();
 	unnamedTransversalCountArray.clear();
+	generatorCountArray.clear();
 }
 
 void StabilizerChain::Stats::Print( std::ostream& ostream ) const
@@ -900,15 +1775,20 @@ void StabilizerChain::Stats::Print( std::ostream& ostream ) const
 
 	//for( uint i = 0; i < unnamedGeneratorCountArray.size(); i++ )
 	//	ostream << unnamedGeneratorCountArray[i] << " unnamed generator elements at level " << i << "\n";
+
+	ostream << "Total generators: " << totalGeneratorCount << "\n";
+
+	for( uint i = 0; i < generatorCountArray.size(); i++ )
+		ostream << generatorCountArray[i] << " generators at level " << i << "\n";
 }
 
 void StabilizerChain::Group::AccumulateStats( Stats& stats ) const
 {
-	uint unnamedTransversalCount = 0;
+	uint unnamedTransversalCount = schreierVector ? schreierVector->OrbitSize() : 0;
 	for( PermutationSet::const_iterator iter = transversalSet.cbegin(); iter != transversalSet.cend(); iter++ )
 	{
 		const Permutation& permutation = *iter;
-		if( !permutation.word )
+		if( !permutation.HasWord() )
 			unnamedTransversalCount++;
 	}
 	
@@ -916,7 +1796,7 @@ void StabilizerChain::Group::AccumulateStats( Stats& stats ) const
 	for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
 	{
 		const Permutation& permutation = *iter;
-		if( !permutation.word )
+		if( !permutation.HasWord() )
 			unnamedGeneratorCount++;
 	}
 
@@ -924,6 +1804,8 @@ void StabilizerChain::Group::AccumulateStats( Stats& stats ) const
 	stats.unnamedGeneratorCountArray.push_back( unnamedGeneratorCount );
 	stats.totalUnnamedTransversalCount += unnamedTransversalCount;
 	stats.totalUnnamedGeneratorCount += unnamedGeneratorCount;
+	stats.generatorCountArray.push_back( ( uint )generatorSet.size() );
+	stats.totalGeneratorCount += ( uint )generatorSet.size();
 
 	if( subGroup )
 		subGroup->AccumulateStats( stats );
@@ -941,9 +1823,9 @@ bool StabilizerChain::Group::IsSubGroupOf( const Group& group ) const
 	return true;
 }
 
-StabilizerChain::OrbitNode::OrbitNode( const Permutation* cosetRepresentative )
+StabilizerChain::OrbitNode::OrbitNode( PermutationSet::Handle cosetHandle )
 {
-	this->cosetRepresentative = cosetRepresentative;
+	this->cosetHandle = cosetHandle;
 }
 
 StabilizerChain::OrbitNode::~OrbitNode( void )
@@ -952,7 +1834,7 @@ StabilizerChain::OrbitNode::~OrbitNode( void )
 		delete adjacentNodeArray[i];
 }
 
-bool StabilizerChain::OrbitNode::Grow( Group* group, const PermutationSet& generatorSet, const PermutationSet& singletonSet, bool fresh, OrbitNodeArray& newOrbitArray )
+bool StabilizerChain::OrbitNode::Grow( Group* group, const PermutationSet& generatorSet, const Permutation& newGenerator, bool fresh, ScratchOrbitNodeArray& newOrbitArray )
 {
 	// The orbit-stabilizer theorem does not generalize to stabilizer subgroups of multiple points.
 	// I did, however, find a generalization of the orbit-stabilizer theorem for permutations
@@ -963,49 +1845,72 @@ bool StabilizerChain::OrbitNode::Grow( Group* group, const PermutationSet& gener
 	if( stabilizerPointSet.Cardinality() != 1 )
 		return false;
 
-	uint stabilizerPoint = *stabilizerPointSet.set.begin();
-
-	const PermutationSet* permutationSet = &generatorSet;
-	if( !fresh )
-		permutationSet = &singletonSet;
-
 	uint nonFreshSize = ( uint )adjacentNodeArray.size();
 
-	for( PermutationSet::const_iterator iter = permutationSet->cbegin(); iter != permutationSet->cend(); iter++ )
+	// A fresh node is grown under every generator, but the others have already been grown
+	// under all of them except the new one.
+	if( fresh )
 	{
-		const Permutation& generator = *iter;
+		for( PermutationSet::const_iterator iter = generatorSet.cbegin(); iter != generatorSet.cend(); iter++ )
+			if( !GrowUnder( group, generatorSet, newGenerator, *iter, newOrbitArray ) )
+				return false;
+	}
+	else if( !GrowUnder( group, generatorSet, newGenerator, newGenerator, newOrbitArray ) )
+		return false;
 
-		Permutation permutation;
-		permutation.Multiply( *cosetRepresentative, generator );
+	for( uint i = 0; i < nonFreshSize; i++ )
+		adjacentNodeArray[i]->Grow( group, generatorSet, newGenerator, false, newOrbitArray );
 
-		uint point = permutation.Evaluate( stabilizerPoint );
+	return true;
+}
 
-		if( !group->orbitSet.IsMember( point ) )
-		{
-			group->orbitSet.AddMember( point );
+bool StabilizerChain::OrbitNode::GrowUnder( Group* group, const PermutationSet& generatorSet, const Permutation& newGenerator, const Permutation& generator, ScratchOrbitNodeArray& newOrbitArray )
+{
+	uint stabilizerPoint = group->GetSubgroupStabilizerPointSet().Min();
 
-			std::ostream* logStream = group->stabChain->logStream;
-			if( logStream )
-			{
-				*logStream << "Found new orbit: " << point << "\n";
-				permutation.Print( *logStream );
-			}
+	// The transversal set may grow as the orbit does, but the representative stays where it is.
+	const Permutation& cosetRepresentative = group->transversalSet.Get( cosetHandle );
 
-			group->transversalSet.insert( permutation );
-			PermutationSet::iterator iter = group->transversalSet.find( permutation );
+	// Most products land back in the orbit, so they're only formed once they don't.
+	uint point = generator.Evaluate( cosetRepresentative.Evaluate( stabilizerPoint ) );
+	if( group->orbitSet.IsMember( point ) )
+		return true;
 
-			OrbitNode* orbitNode = new OrbitNode( &( *iter ) );
-			newOrbitArray.push_back( orbitNode );
-			adjacentNodeArray.push_back( orbitNode );
-			if( !orbitNode->Grow( group, generatorSet, singletonSet, true, newOrbitArray ) )
-				return false;
-		}
+	Permutation permutation;
+	permutation.Multiply( cosetRepresentative, generator );
+
+	group->orbitSet.AddMember( point );
+
+	std::ostream* logStream = group->stabChain->logStream;
+	if( logStream )
+	{
+		*logStream << "Found new orbit: " << point << "\n";
+		permutation.Print( *logStream );
 	}
 
-	for( uint i = 0; i < nonFreshSize; i++ )
-		adjacentNodeArray[i]->Grow( group, generatorSet, singletonSet, false, newOrbitArray );
+	PermutationSet::iterator iter = group->transversalSet.insert( std::move( permutation ) ).first;
+	group->IndexCosetRepresentative( iter.handle );
 
-	return true;
+	OrbitNode* orbitNode = new OrbitNode( iter.handle );
+	newOrbitArray.push_back( orbitNode );
+	adjacentNodeArray.push_back( orbitNode );
+	return orbitNode->Grow( group, generatorSet, newGenerator, true, newOrbitArray );
+}
+
+StabilizerChain::SchreierPairSifter::SchreierPairSifter( const Group* group, SchreierPair* pairArray )
+{
+	this->group = group;
+	this->pairArray = pairArray;
+}
+
+/*virtual*/ StabilizerChain::SchreierPairSifter::~SchreierPairSifter( void )
+{
+}
+
+/*virtual*/ void StabilizerChain::SchreierPairSifter::Perform( uint index )
+{
+	Permutation schreierGenerator;
+	group->SiftSchreierPair( pairArray[ index ], schreierGenerator );
 }
 
 // StabilizerChain.cpp
\ No newline at end of file
@@ -3,8 +3,12 @@
 #pragma once
 
 #include "Permutation.h"
+#include "PermutationExpression.h"
 #include "NaturalNumberSet.h"
+#include "ScratchArena.h"
+#include "ThreadPool.h"
 #include <vector>
+#include <unordered_map>
 #include <iostream>
 #include <string>
 #include "rapidjson/document.h"
@@ -13,6 +17,10 @@ typedef std::vector< uint > UintArray;
 
 class PermutationStreamCreator;
 class PermutationStream;
+class PointRelabeling;
+class SchreierVector;
+class PermutationEncoder;
+class PermutationDecoder;
 
 // One idea that would certainly reduce factorization sizes is to use a stabilizer tree, instead of a chain.
 // This would come at high memory cost, unless the tree wasn't as full as it could be.  In any case, the sifting
@@ -29,29 +37,63 @@ public:
 	virtual ~StabilizerChain( void );
 
 	bool Generate( const PermutationSet& generatorSet, const UintArray& baseArray );
+	bool SchreierSims( const PermutationSet& generatorSet, const UintArray& baseArray );
+	bool RandomSchreierSims( const PermutationSet& generatorSet, const UintArray& baseArray );
+	bool CompleteDeterministically( void );
+	void BeginGeneration( const UintArray& baseArray );
+	bool FinishGeneration( void );
+	void FromDense( const PointRelabeling& relabeling );
 	void Print( std::ostream& ostream ) const;
 	bool LoadFromJsonString( const std::string& jsonString );
 	bool SaveToJsonString( std::string& jsonString ) const;
+	bool LoadFromBinaryString( const std::string& binaryString );
+	bool SaveToBinaryString( std::string& binaryString ) const;
 	uint Depth( void ) const;
 	Group* GetSubGroupAtDepth( uint depth );
 	const Group* GetSubGroupAtDepth( uint depth ) const;
 	StabilizerChain* Clone( void ) const;
+	void MaterializeTransversals( void );
 
 	class OrbitNode;
 	class Group;
 
 	typedef std::vector< OrbitNode* > OrbitNodeArray;
+	typedef std::vector< OrbitNode*, ScratchAllocator< OrbitNode* > > ScratchOrbitNodeArray;
+
+	// A pair of a coset representative and a generator gives a Schreier generator.  When the
+	// pairs are sifted in parallel, the representative of the coset the pair lands in, and
+	// what became of its Schreier generator, are found ahead of the sift that can extend the
+	// sub-group, which is then only made for those pairs left as candidates.
+	struct SchreierPair
+	{
+		enum State
+		{
+			StateUnknown,
+			StateTrivial,
+			StateCandidate,
+			StateFailed
+		};
+
+		const Permutation* cosetRepresentative;
+		const Permutation* generator;
+		const Permutation* imageRepresentative;
+		State state;
+	};
+
+	typedef std::vector< SchreierPair, ScratchAllocator< SchreierPair > > ScratchSchreierPairArray;
 
 	class OrbitNode
 	{
 	public:
 
-		OrbitNode( const Permutation* cosetRepresentative );
+		OrbitNode( PermutationSet::Handle cosetHandle );
 		~OrbitNode( void );
 
-		bool Grow( Group* group, const PermutationSet& generatorSet, const PermutationSet& singletonSet, bool fresh, OrbitNodeArray& newOrbitArray );
+		bool Grow( Group* group, const PermutationSet& generatorSet, const Permutation& newGenerator, bool fresh, ScratchOrbitNodeArray& newOrbitArray );
+		bool GrowUnder( Group* group, const PermutationSet& generatorSet, const Permutation& newGenerator, const Permutation& generator, ScratchOrbitNodeArray& newOrbitArray );
 
-		const Permutation* cosetRepresentative;
+		// The coset representative is kept in the transversal set of the group.
+		PermutationSet::Handle cosetHandle;
 		OrbitNodeArray adjacentNodeArray;
 	};
 
@@ -61,8 +103,10 @@ public:
 
 		uint totalUnnamedTransversalCount;
 		uint totalUnnamedGeneratorCount;
+		uint totalGeneratorCount;
 		UintArray unnamedTransversalCountArray;
 		UintArray unnamedGeneratorCountArray;
+		UintArray generatorCountArray;
 
 		void Reset( void );
 		void Print( std::ostream& ostream ) const;
@@ -76,11 +120,34 @@ public:
 		virtual ~Group( void );
 
 		bool Extend( const Permutation& generator, bool* extended = nullptr );
+		bool ExtendSchreierVector( const Permutation& generator );
+		bool ExtendOrbit( const Permutation& generator );
+		bool ExtendSubGroup( const Permutation& cosetRepresentative, const Permutation& generator, const Permutation& imageRepresentative, Permutation& schreierGenerator );
+		bool ExtendSubGroup( ScratchSchreierPairArray& pairArray );
+		void SiftSchreierPair( SchreierPair& pair, Permutation& schreierGenerator ) const;
+		void SetShared( bool shared );
+
+		// This many pairs per thread are sifted in parallel before the calling thread extends
+		// the sub-group with the candidates among them.  The fewer there are, the less out of
+		// date the chain they're sifted against, but the more often the threads have to wait.
+		static const uint schreierPairsPerThread = 32;
+		bool ExtendWithSchreierGenerators( void );
+		bool SiftIn( const Permutation& element, bool& trivial );
+		bool MakeRootNode( uint degree );
+		bool MakeSchreierVector( void );
+		bool AddGenerator( const Permutation& generator, const Permutation*& addedGenerator );
+		bool FilterGenerator( Permutation& generator, uint64_t& filterKey ) const;
 		bool Eliminate( void );		// If successful, the caller owns the group memory and should delete it if they don't want it.
 		bool IsMember( const Permutation& permutation ) const;
 		bool FactorInverse( const Permutation& permutation, Permutation& invPermutation ) const;
 		bool FactorInverseWithTrembling( const Permutation& permutation, Permutation& invPermutation, const PermutationSet& trembleSet, const CompressInfo& compressInfo ) const;
 		PermutationSet::iterator FindCoset( const Permutation& permutation );
+		template< typename Expression > PermutationSet::iterator FindCoset( const PermutationExpression< Expression >& expression );
+		const Permutation* FindCosetRepresentative( const Permutation& permutation, Permutation& representative ) const;
+		uint TransversalSize( void ) const;
+		void MaterializeTransversal( void );
+		void IndexTransversalSet( void );
+		bool IndexCosetRepresentative( PermutationSet::Handle handle );
 		const NaturalNumberSet& GetSubgroupStabilizerPointSet( void ) const;
 		void Print( std::ostream& ostream ) const;
 		bool StabilizesPoint( uint point ) const;
@@ -90,7 +157,9 @@ public:
 		void AccumulateStats( Stats& stats ) const;
 		bool LoadRecursive( /*const*/ rapidjson::Value& chainGroupValue );
 		bool SaveRecursive( rapidjson::Value& chainGroupValue, rapidjson::Document::AllocatorType& allocator ) const;
-		unsigned long long Order( void ) const;
+		bool LoadRecursive( PermutationDecoder& decoder );
+		bool SaveRecursive( PermutationEncoder& encoder ) const;
+		BigUint Order( void ) const;
 		bool IsSubGroupOf( const Group& group ) const;
 
 		NaturalNumberSet orbitSet;
@@ -98,20 +167,108 @@ public:
 		uint stabilizerOffset;
 		PermutationSet generatorSet;
 		PermutationSet transversalSet;
+		SchreierVector* schreierVector;		// If this is set, it takes the place of the transversal set.
+
+		// No two coset representatives take the key point to the same place, so entry p here is
+		// the handle of the one that takes it to p, if there is one.  Without a key point, the
+		// transversal set has to be searched.
+		uint cosetKeyPoint;
+		std::vector< PermutationSet::Handle > cosetHandleArray;
+		static const uint invalidKeyPoint = 0xFFFFFFFF;
+
+		// This is only kept while the chain is being generated.  It takes a point, in the high
+		// half of the key, and its image, in the low half, to the generator kept for them by
+		// Sims' filter.
+		typedef std::unordered_map< uint64_t, PermutationSet::Handle > FilterMap;
+		FilterMap filterMap;
 		Group* subGroup;
 		Group* superGroup;
 		StabilizerChain* stabChain;
 	};
 
+	class SchreierPairSifter : public ThreadPool::Job
+	{
+	public:
+
+		SchreierPairSifter( const Group* group, SchreierPair* pairArray );
+		virtual ~SchreierPairSifter( void );
+
+		virtual void Perform( uint index ) override;
+
+		const Group* group;
+		SchreierPair* pairArray;
+	};
+
 	typedef bool ( *OptimizeNamesCallback )( const Stats*, bool, double, void* );
 	bool OptimizeNames( PermutationStream& permutationStream, const CompressInfo& compressInfo, OptimizeNamesCallback callback, void* callback_data = nullptr );
 	bool IsCompletelyWorded( void ) const;
+	bool VerifyWords( const CompressInfo& compressInfo, uint* badWordCount = nullptr ) const;
 	bool FindUnwordedCosetRepresentative( Group*& subGroup, PermutationSet::iterator& iter );
 	bool TryToCompletePartiallyWordedChain( PermutationStream& permutationStream, const CompressInfo& compressInfo, OptimizeNamesCallback callback, void* callback_data = nullptr );
 
 	Group* group;
 	NaturalNumberSetArray baseArray;
 	std::ostream* logStream;
+
+	// When this is set, the chain is generated with a Schreier vector at each level in place of
+	// a transversal set, and up to the given number of representatives are kept at each level.
+	// Anything that needs words for the representatives materializes the transversal sets first.
+	bool useSchreierVectors;
+	uint representativeCacheSize;
+
+	// When the sift limit isn't zero, the chain is generated by sifting random elements of the
+	// group into it, rather than every Schreier generator, until that many in a row sift to the
+	// identity.  The chance that the chain is then missing something is about one in two to the
+	// power of the limit.  If the order of the group is known, generation stops as soon as the
+	// chain reaches it, and the limit only says when to stop trying random elements and finish
+	// the chain deterministically.  Verification runs the deterministic algorithm over the
+	// randomized chain, which completes it if it's missing anything.
+	uint randomSiftLimit;
+	uint randomSeed;
+	BigUint knownOrder;
+	bool verifyRandomChain;
+
+	// With more than one thread, the deterministic algorithm sifts the Schreier generators it
+	// makes against the chain below in parallel, and the chain only grows where a sift can't be
+	// finished.  This gives the same chain as a single thread would.  The pool only exists while
+	// the chain is being generated.
+	uint threadCount;
+	ThreadPool* threadPool;
 };
 
+// A coset representative is in the same coset as the given element when the product of the
+// representative and the element's inverse fixes every stabilizer point, which is just when the
+// two agree on those points.  So the element never needs to be inverted or even multiplied out.
+// The only representative that can agree with it is the one indexed by its image of the key
+// point, so that's the only one that needs to be checked.
+template< typename Expression >
+PermutationSet::iterator StabilizerChain::Group::FindCoset( const PermutationExpression< Expression >& expression )
+{
+	const NaturalNumberSet& stabilizerPointSet = GetSubgroupStabilizerPointSet();
+
+	if( cosetKeyPoint != invalidKeyPoint )
+	{
+		uint image = expression.Evaluate( cosetKeyPoint );
+		if( image >= cosetHandleArray.size() || cosetHandleArray[ image ] == PermutationSet::nullHandle )
+			return transversalSet.end();
+
+		PermutationSet::iterator iter( &transversalSet, cosetHandleArray[ image ] );
+		if( !( *iter * Inverse( expression ) ).Stabilizes( stabilizerPointSet ) )
+			return transversalSet.end();
+
+		return iter;
+	}
+
+	PermutationSet::iterator iter = transversalSet.begin();
+	while( iter != transversalSet.end() )
+	{
+		if( ( *iter * Inverse( expression ) ).Stabilizes( stabilizerPointSet ) )
+			break;
+
+		iter++;
+	}
+
+	return iter;
+}
+
 // StabilizerChain.h
\ No newline at end of file
@@ -0,0 +1,104 @@
+// ThreadPool.cpp
+
+#include "ThreadPool.h"
+
+//------------------------------------------------------------------------------------------
+//                                       ThreadPool
+//------------------------------------------------------------------------------------------
+
+ThreadPool::ThreadPool( uint threadCount )
+{
+	job = nullptr;
+	taskCount = 0;
+	jobCount = 0;
+	busyWorkerCount = 0;
+	stopping = false;
+	nextTaskIndex = 0;
+
+	for( uint i = 1; i < threadCount; i++ )
+		threadArray.push_back( std::thread( &ThreadPool::WorkerLoop, this ) );
+}
+
+ThreadPool::~ThreadPool( void )
+{
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		stopping = true;
+	}
+
+	startCondition.notify_all();
+
+	for( uint i = 0; i < threadArray.size(); i++ )
+		threadArray[i].join();
+}
+
+// Every worker has to check in before this returns, even if there were no tasks left for it
+// by the time it woke up, so that no worker can still be looking at this job once the next begins.
+void ThreadPool::Run( Job& job, uint taskCount )
+{
+	if( threadArray.size() == 0 || taskCount <= 1 )
+	{
+		for( uint i = 0; i < taskCount; i++ )
+			job.Perform(i);
+
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		this->job = &job;
+		this->taskCount = taskCount;
+		nextTaskIndex = 0;
+		busyWorkerCount = ( uint )threadArray.size();
+		jobCount++;
+	}
+
+	startCondition.notify_all();
+
+	PerformTasks();
+
+	std::unique_lock< std::mutex > lock( mutex );
+	while( busyWorkerCount > 0 )
+		finishCondition.wait( lock );
+
+	this->job = nullptr;
+}
+
+void ThreadPool::WorkerLoop( void )
+{
+	uint seenJobCount = 0;
+
+	while( true )
+	{
+		{
+			std::unique_lock< std::mutex > lock( mutex );
+			while( !stopping && jobCount == seenJobCount )
+				startCondition.wait( lock );
+
+			if( stopping )
+				return;
+
+			seenJobCount = jobCount;
+		}
+
+		PerformTasks();
+
+		std::lock_guard< std::mutex > lock( mutex );
+		if( --busyWorkerCount == 0 )
+			finishCondition.notify_one();
+	}
+}
+
+void ThreadPool::PerformTasks( void )
+{
+	while( true )
+	{
+		uint index = nextTaskIndex.fetch_add(1);
+		if( index >= taskCount )
+			return;
+
+		job->Perform( index );
+	}
+}
+
+// ThreadPool.cpp
@@ -0,0 +1,65 @@
+// ThreadPool.h
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+typedef unsigned int uint;
+
+//------------------------------------------------------------------------------------------
+//                                       ThreadPool
+//------------------------------------------------------------------------------------------
+
+// This is a fixed set of worker threads that run one job at a time.  A job is some number of
+// tasks, each known only by its index, and the thread that runs the job takes on tasks along
+// with the workers, returning only once every task is done.  The tasks are handed out one at
+// a time from a shared counter, so threads that get through theirs quickly take on more.
+// Only one thread should ever run jobs on a pool, and never from within a task.
+class ThreadPool
+{
+public:
+
+	// The tasks of a job may all be performed at once, so this must be safe to call from
+	// any number of threads, as long as no two are given the same index.
+	class Job
+	{
+	public:
+
+		virtual ~Job( void ) {}
+		virtual void Perform( uint index ) = 0;
+	};
+
+	// The thread count includes the thread that runs the jobs, so one less than this are made.
+	ThreadPool( uint threadCount );
+	~ThreadPool( void );
+
+	void Run( Job& job, uint taskCount );
+
+	uint ThreadCount( void ) const { return ( uint )threadArray.size() + 1; }
+
+private:
+
+	void WorkerLoop( void );
+	void PerformTasks( void );
+
+	std::vector< std::thread > threadArray;
+	std::mutex mutex;
+	std::condition_variable startCondition;
+	std::condition_variable finishCondition;
+
+	// These are only changed under the mutex, while no job is running.  The job count tells
+	// a waking worker whether there's a job it hasn't yet taken part in.
+	Job* job;
+	uint taskCount;
+	uint jobCount;
+	uint busyWorkerCount;
+	bool stopping;
+
+	std::atomic< uint > nextTaskIndex;
+};
+
+// ThreadPool.h
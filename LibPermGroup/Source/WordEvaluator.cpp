@@ -0,0 +1,117 @@
+// WordEvaluator.cpp
+
+#include "WordEvaluator.h"
+
+//------------------------------------------------------------------------------------------
+//                                     WordEvaluator
+//------------------------------------------------------------------------------------------
+
+// Flattened programs and untabulated powers are made here.
+static thread_local ElementArray scratchWord;
+static thread_local Permutation scratchPower;
+static thread_local Permutation scratchProduct;
+
+WordEvaluator::WordEvaluator( void )
+{
+}
+
+WordEvaluator::~WordEvaluator( void )
+{
+}
+
+void WordEvaluator::Build( const CompressInfo& compressInfo )
+{
+	generatorArray.clear();
+
+	for( PermutationMap::const_iterator iter = compressInfo.permutationMap.cbegin(); iter != compressInfo.permutationMap.cend(); iter++ )
+	{
+		Element element;
+		element.id = GeneratorAlphabet::Intern( iter->first );
+		element.exponent = 1;
+
+		if( element.id >= generatorArray.size() )
+		{
+			uint oldSize = ( uint )generatorArray.size();
+			generatorArray.resize( element.id + 1 );
+			for( uint i = oldSize; i < generatorArray.size(); i++ )
+			{
+				generatorArray[i].defined = false;
+				generatorArray[i].order = 0;
+			}
+		}
+
+		Generator& generator = generatorArray[ element.id ];
+		generator.defined = true;
+		generator.order = compressInfo.ElementOrder( element );
+		generator.permutation.SetCopy( iter->second, false );
+		generator.powerArray.clear();
+
+		if( generator.order == 0 || generator.order > maxTabulatedOrder )
+			continue;
+
+		// Each power is the one before it times the generator, so they're made in one pass.
+		generator.powerArray.resize( generator.order );
+		for( uint k = 1; k < generator.order; k++ )
+			generator.powerArray[k].Multiply( generator.powerArray[ k - 1 ], generator.permutation );
+	}
+}
+
+bool WordEvaluator::Evaluate( const ElementArray& word, Permutation& permutation ) const
+{
+	permutation.DefineIdentity();
+	permutation.word.reset();
+	permutation.wordProgram.reset();
+
+	for( ElementArray::const_iterator iter = word.cbegin(); iter != word.cend(); iter++ )
+	{
+		const Element& element = *iter;
+		if( element.id >= generatorArray.size() || !generatorArray[ element.id ].defined )
+			return false;
+
+		const Generator& generator = generatorArray[ element.id ];
+
+		if( generator.powerArray.size() > 0 )
+		{
+			int exponent = element.exponent % int( generator.order );
+			if( exponent < 0 )
+				exponent += generator.order;
+
+			if( exponent != 0 )
+				permutation.MultiplyOnRight( generator.powerArray[ exponent ] );
+		}
+		else
+		{
+			scratchPower.Power( generator.permutation, element.exponent );
+			permutation.MultiplyOnRight( scratchPower );
+		}
+	}
+
+	return true;
+}
+
+bool WordEvaluator::Evaluate( const WordProgram& wordProgram, Permutation& permutation ) const
+{
+	scratchWord.clear();
+	wordProgram.Flatten( scratchWord );
+	return Evaluate( scratchWord, permutation );
+}
+
+bool WordEvaluator::Verify( const Permutation& permutation ) const
+{
+	if( permutation.wordProgram )
+	{
+		if( !Evaluate( *permutation.wordProgram, scratchProduct ) )
+			return false;
+	}
+	else if( permutation.word )
+	{
+		if( !Evaluate( *permutation.word, scratchProduct ) )
+			return false;
+	}
+	else
+		return false;
+
+	return scratchProduct.IsEqualTo( permutation );
+}
+
+// WordEvaluator.cpp
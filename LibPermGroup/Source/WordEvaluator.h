@@ -0,0 +1,53 @@
+// WordEvaluator.h
+
+#pragma once
+
+#include "Permutation.h"
+#include <vector>
+
+//------------------------------------------------------------------------------------------
+//                                     WordEvaluator
+//------------------------------------------------------------------------------------------
+
+// This turns words back into the permutations they stand for.  Every power of every
+// generator below its order is made once up front, so each element of a word costs a
+// single product, whatever its exponent, and the word is multiplied out left to right
+// into the one permutation.  Generators of large or unknown order aren't tabulated, and
+// their powers are made from their cycles as they're needed instead.
+class WordEvaluator
+{
+public:
+
+	WordEvaluator( void );
+	~WordEvaluator( void );
+
+	// The generators are those of the compress info, and are looked up by their ids.
+	void Build( const CompressInfo& compressInfo );
+
+	// These fail if the word uses a generator that the evaluator wasn't built with.
+	// The permutation is given no word.
+	bool Evaluate( const ElementArray& word, Permutation& permutation ) const;
+	bool Evaluate( const WordProgram& wordProgram, Permutation& permutation ) const;
+
+	// This is whether the permutation's word gives the permutation.  A permutation with no
+	// word doesn't pass.
+	bool Verify( const Permutation& permutation ) const;
+
+	static const uint maxTabulatedOrder = 64;
+
+	struct Generator
+	{
+		bool defined;
+		uint order;
+		Permutation permutation;
+
+		// Entry k is the k-th power, or this is empty if the generator isn't tabulated.
+		PermutationArray powerArray;
+	};
+
+	typedef std::vector< Generator > GeneratorArray;
+
+	GeneratorArray generatorArray;
+};
+
+// WordEvaluator.h
@@ -3,6 +3,8 @@
 #include <Python.h>
 #include "PyPerm.h"
 #include <sstream>
+#include <new>
+#include <stdexcept>
 
 struct PyPermObject
 {
@@ -21,9 +23,12 @@ static PyObject* PyPermObject_to_array(PyPermObject* self, PyObject* args);
 static PyObject* PyPermObject_from_array(PyPermObject* self, PyObject* args);
 static PyObject* PyPermObject_to_json(PyPermObject* self, PyObject* args);
 static PyObject* PyPermObject_from_json(PyPermObject* self, PyObject* args);
+static PyObject* PyPermObject_to_bytes(PyPermObject* self, PyObject* args);
+static PyObject* PyPermObject_from_bytes(PyPermObject* self, PyObject* args);
 static PyObject* PyPermObject_clone(PyPermObject* self, PyObject* args);
 static PyObject* PyPermObject_overload_multiply(PyObject* leftObject, PyObject* rightObject);
 static PyObject* PyPermObject_overload_invert(PyObject* object);
+static PyObject* PyPermObject_overload_power(PyObject* baseObject, PyObject* exponentObject, PyObject* moduloObject);
 static PyObject* PyPermObject_overload_str(PyObject* object);
 static PyObject* PyPermObject_overload_repr(PyObject* object);
 static PyObject* PyPermObject_overload_new(PyTypeObject* type, PyObject* args, PyObject* kwds);
@@ -41,6 +46,8 @@ PyMethodDef PyPermObject_methods[] =
 	{"from_array", (PyCFunction)PyPermObject_from_array, METH_VARARGS, ""},
 	{"to_json", (PyCFunction)PyPermObject_to_json, METH_VARARGS, ""},
 	{"from_json", (PyCFunction)PyPermObject_from_json, METH_VARARGS, ""},
+	{"to_bytes", (PyCFunction)PyPermObject_to_bytes, METH_VARARGS, ""},
+	{"from_bytes", (PyCFunction)PyPermObject_from_bytes, METH_VARARGS, ""},
 	{"clone", (PyCFunction)PyPermObject_clone, METH_VARARGS, ""},
 	{nullptr, nullptr, 0, nullptr}
 };
@@ -52,7 +59,7 @@ PyNumberMethods PyPermObject_numberMethods =
 	PyPermObject_overload_multiply,						// nb_multiply
 	nullptr,											// nb_remainder
 	nullptr,											// nb_divmod
-	nullptr,											// nb_power
+	PyPermObject_overload_power,						// nb_power
 	nullptr,											// nb_negative
 	nullptr,											// nb_positive
 	nullptr,											// nb_absolute
@@ -179,6 +186,12 @@ static bool _PyPermObject_populate(PyPermObject* self, PyObject* perm_array_obj)
 		}
 
 		unsigned int output = (unsigned int)PyLong_AsSize_t(obj);
+		if(input >= PointMap::maxDegree || output >= PointMap::maxDegree)
+		{
+			PyErr_SetString(PyExc_ValueError, "Point exceeds the maximum degree.");
+			return false;
+		}
+
 		self->permutation->Define(input, output);
 	}
 
@@ -233,6 +246,12 @@ static PyObject* PyPermObject_define(PyPermObject* self, PyObject* args)
 	if(!PyArg_ParseTuple(args, "II", &input, &output))
 		return nullptr;
 
+	if(input >= PointMap::maxDegree || output >= PointMap::maxDegree)
+	{
+		PyErr_SetString(PyExc_ValueError, "Point exceeds the maximum degree.");
+		return nullptr;
+	}
+
 	self->permutation->Define(input, output);
 
 	Py_INCREF(self);
@@ -263,6 +282,12 @@ static PyObject* PyPermObject_define_cycle(PyPermObject* self, PyObject* args)
 		unsigned int j = (i + 1) % count;
 		obj = PyList_GetItem(cycle_list_obj, j);
 		unsigned int output = (unsigned int)PyLong_AsSize_t(obj);
+		if(input >= PointMap::maxDegree || output >= PointMap::maxDegree)
+		{
+			PyErr_SetString(PyExc_ValueError, "Point exceeds the maximum degree.");
+			return nullptr;
+		}
+
 		self->permutation->Define(input, output);
 	}
 
@@ -293,9 +318,9 @@ static PyObject* PyPermObject_is_identity(PyPermObject* self, PyObject* args)
 
 static PyObject* PyPermObject_to_array(PyPermObject* self, PyObject* args)
 {
-	PyObject* perm_array = PyList_New((unsigned int)self->permutation->map.size());
+	PyObject* perm_array = PyList_New((unsigned int)self->permutation->map.Size());
 
-	for(unsigned int input = 0; input < (unsigned int)self->permutation->map.size(); input++)
+	for(unsigned int input = 0; input < (unsigned int)self->permutation->map.Size(); input++)
 	{
 		unsigned int output = self->permutation->map[input];
 		PyObject* obj = PyLong_FromSize_t(output);
@@ -324,8 +349,25 @@ static PyObject* PyPermObject_from_array(PyPermObject* self, PyObject* args)
 
 static PyObject* PyPermObject_to_json(PyPermObject* self, PyObject* args)
 {
+	// A word made by a large power may be too long to write out.
 	std::string jsonString;
-	if(!self->permutation->SaveToJsonString(jsonString))
+	bool saved = false;
+	try
+	{
+		saved = self->permutation->SaveToJsonString(jsonString);
+	}
+	catch(const std::bad_alloc&)
+	{
+		PyErr_NoMemory();
+		return nullptr;
+	}
+	catch(const std::length_error&)
+	{
+		PyErr_NoMemory();
+		return nullptr;
+	}
+
+	if(!saved)
 	{
 		PyErr_SetString(PyExc_ValueError, "Failed to generate json text from permutation.");
 		return nullptr;
@@ -355,6 +397,57 @@ static PyObject* PyPermObject_from_json(PyPermObject* self, PyObject* args)
 	Py_RETURN_NONE;
 }
 
+static PyObject* PyPermObject_to_bytes(PyPermObject* self, PyObject* args)
+{
+	// A word made by a large power may be too long to write out.
+	std::string binaryString;
+	bool saved = false;
+	try
+	{
+		saved = self->permutation->SaveToBinaryString(binaryString);
+	}
+	catch(const std::bad_alloc&)
+	{
+		PyErr_NoMemory();
+		return nullptr;
+	}
+	catch(const std::length_error&)
+	{
+		PyErr_NoMemory();
+		return nullptr;
+	}
+
+	if(!saved)
+	{
+		PyErr_SetString(PyExc_ValueError, "Failed to generate bytes from permutation.");
+		return nullptr;
+	}
+
+	return PyBytes_FromStringAndSize(binaryString.data(), binaryString.size());
+}
+
+static PyObject* PyPermObject_from_bytes(PyPermObject* self, PyObject* args)
+{
+	PyObject* bytes_obj = nullptr;
+	char* bytes = nullptr;
+	Py_ssize_t size = 0;
+
+	if(!PyArg_ParseTuple(args, "S", &bytes_obj) || PyBytes_AsStringAndSize(bytes_obj, &bytes, &size) < 0)
+	{
+		PyErr_SetString(PyExc_ValueError, "Expected bytes argument.");
+		return nullptr;
+	}
+
+	std::string binaryString(bytes, size);
+	if(!self->permutation->LoadFromBinaryString(binaryString))
+	{
+		PyErr_SetString(PyExc_ValueError, "Failed to generate permutation from bytes.");
+		return nullptr;
+	}
+
+	Py_RETURN_NONE;
+}
+
 static PyObject* PyPermObject_clone(PyPermObject* self, PyObject* args)
 {
 	if(self->permutation == nullptr)
@@ -407,6 +500,40 @@ static PyObject* PyPermObject_overload_invert(PyObject* object)
 	return Permutation_to_PyObject(invPermutation);
 }
 
+static PyObject* PyPermObject_overload_power(PyObject* baseObject, PyObject* exponentObject, PyObject* moduloObject)
+{
+	if(!PyObject_TypeCheck(baseObject, &PyPermTypeObject) || !PyLong_Check(exponentObject) || moduloObject != Py_None)
+	{
+		PyErr_SetString(PyExc_TypeError, "Can only raise a permutation object to an integer power.");
+		return nullptr;
+	}
+
+	int overflow = 0;
+	long exponent = PyLong_AsLongAndOverflow(exponentObject, &overflow);
+	if(overflow != 0 || exponent < INT_MIN || exponent > INT_MAX)
+	{
+		PyErr_SetString(PyExc_OverflowError, "Exponent is too large.");
+		return nullptr;
+	}
+
+	const Permutation* basePerm = ((PyPermObject*)baseObject)->permutation;
+
+	// Running out of memory has to reach Python as an exception, not unwind through the interpreter.
+	Permutation* power = new Permutation();
+	try
+	{
+		power->Power(*basePerm, int(exponent));
+	}
+	catch(const std::bad_alloc&)
+	{
+		delete power;
+		PyErr_NoMemory();
+		return nullptr;
+	}
+
+	return Permutation_to_PyObject(power);
+}
+
 static PyObject* PyPermObject_overload_str(PyObject* object)
 {
 	if(!PyObject_TypeCheck(object, &PyPermTypeObject))
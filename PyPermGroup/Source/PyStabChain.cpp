@@ -16,6 +16,8 @@ static void PyStabChainObject_dealloc(PyStabChainObject* self);
 static int PyStabChainObject_init(PyStabChainObject* self, PyObject* args, PyObject* kwds);
 static PyObject* PyStabChainObject_to_json(PyStabChainObject* self, PyObject* args);
 static PyObject* PyStabChainObject_from_json(PyStabChainObject* self, PyObject* args);
+static PyObject* PyStabChainObject_to_bytes(PyStabChainObject* self, PyObject* args);
+static PyObject* PyStabChainObject_from_bytes(PyStabChainObject* self, PyObject* args);
 static PyObject* PyStabChainObject_clone(PyStabChainObject* self, PyObject* args);
 static PyObject* PyStabChainObject_depth(PyStabChainObject* self, PyObject* args);
 static PyObject* PyStabChainObject_generate(PyStabChainObject* self, PyObject* args);
@@ -32,6 +34,8 @@ PyMethodDef PyStabChainObject_methods[] =
 {
 	{"to_json", (PyCFunction)PyStabChainObject_to_json, METH_VARARGS, ""},
 	{"from_json", (PyCFunction)PyStabChainObject_from_json, METH_VARARGS, ""},
+	{"to_bytes", (PyCFunction)PyStabChainObject_to_bytes, METH_VARARGS, ""},
+	{"from_bytes", (PyCFunction)PyStabChainObject_from_bytes, METH_VARARGS, ""},
 	{"clone", (PyCFunction)PyStabChainObject_clone, METH_VARARGS, ""},
 	{"depth", (PyCFunction)PyStabChainObject_depth, METH_VARARGS, ""},
 	{"generate", (PyCFunction)PyStabChainObject_generate, METH_VARARGS, ""},
@@ -156,6 +160,40 @@ static PyObject* PyStabChainObject_from_json(PyStabChainObject* self, PyObject*
 	Py_RETURN_NONE;
 }
 
+static PyObject* PyStabChainObject_to_bytes(PyStabChainObject* self, PyObject* args)
+{
+	std::string binaryString;
+
+	if(!self->stabChain->SaveToBinaryString(binaryString))
+	{
+		PyErr_SetString(PyExc_ValueError, "Failed to serialize stab-chain.");
+		return nullptr;
+	}
+
+	return PyBytes_FromStringAndSize(binaryString.data(), binaryString.size());
+}
+
+static PyObject* PyStabChainObject_from_bytes(PyStabChainObject* self, PyObject* args)
+{
+	PyObject* bytes_obj = nullptr;
+	char* bytes = nullptr;
+	Py_ssize_t size = 0;
+
+	if(!PyArg_ParseTuple(args, "S", &bytes_obj) || PyBytes_AsStringAndSize(bytes_obj, &bytes, &size) < 0)
+	{
+		PyErr_SetString(PyExc_ValueError, "Expected bytes.");
+		return nullptr;
+	}
+
+	if(!self->stabChain->LoadFromBinaryString(std::string(bytes, size)))
+	{
+		PyErr_SetString(PyExc_ValueError, "Failed to deserialize stab-chain.");
+		return nullptr;
+	}
+
+	Py_RETURN_NONE;
+}
+
 static PyObject* PyStabChainObject_clone(PyStabChainObject* self, PyObject* args)
 {
 	if(self->stabChain == nullptr)
@@ -179,8 +217,13 @@ static PyObject* PyStabChainObject_generate(PyStabChainObject* self, PyObject* a
 {
 	PyObject* generator_list_obj = nullptr;
 	PyObject* base_array_obj = nullptr;
+	int use_schreier_vectors = 0;
+	unsigned int random_sift_limit = 0;
+	PyObject* order_obj = Py_None;
+	int verify = 0;
+	unsigned int thread_count = 1;
 
-	if(!PyArg_ParseTuple(args, "OO", &generator_list_obj, &base_array_obj))
+	if(!PyArg_ParseTuple(args, "OO|pIOpI", &generator_list_obj, &base_array_obj, &use_schreier_vectors, &random_sift_limit, &order_obj, &verify, &thread_count))
 	{
 		PyErr_SetString(PyExc_ValueError, "Failed to parse arguments.");
 		return nullptr;
@@ -226,6 +269,32 @@ static PyObject* PyStabChainObject_generate(PyStabChainObject* self, PyObject* a
 		baseArray.push_back((uint)PyLong_AsSize_t(point_obj));
 	}
 
+	BigUint knownOrder;
+	if(order_obj != Py_None)
+	{
+		if(!PyLong_Check(order_obj))
+		{
+			PyErr_SetString(PyExc_TypeError, "Expected fifth argument to be an integer (the order of the group.)");
+			return nullptr;
+		}
+
+		PyObject* order_str_obj = PyObject_Str(order_obj);
+		const char* order_str = order_str_obj ? PyUnicode_AsUTF8(order_str_obj) : nullptr;
+		bool parsed = order_str && knownOrder.FromString(order_str);
+		Py_XDECREF(order_str_obj);
+		if(!parsed)
+		{
+			PyErr_SetString(PyExc_ValueError, "Failed to read the order of the group.");
+			return nullptr;
+		}
+	}
+
+	self->stabChain->useSchreierVectors = use_schreier_vectors ? true : false;
+	self->stabChain->randomSiftLimit = random_sift_limit;
+	self->stabChain->knownOrder = knownOrder;
+	self->stabChain->verifyRandomChain = verify ? true : false;
+	self->stabChain->threadCount = thread_count;
+
 	if(!self->stabChain->Generate(generatorSet, baseArray))
 	{
 		PyErr_SetString(PyExc_ValueError, "Failed to generated stabilizer chain.");
@@ -330,7 +399,7 @@ static PyObject* PyStabChainObject_solve(PyStabChainObject* self, PyObject* args
 
 	const NaturalNumberSet& stabilizerSet = self->stabChain->group->GetSubgroupStabilizerPointSet();
 
-	PermutationOrbitStream* permutationOrbitStream = new PermutationOrbitStream(&self->stabChain->group->generatorSet, *stabilizerSet.set.begin(), &compressInfo);
+	PermutationOrbitStream* permutationOrbitStream = new PermutationOrbitStream(&self->stabChain->group->generatorSet, stabilizerSet.Min(), &compressInfo);
 
 	PermutationWordStream* permutationWordStream = new PermutationWordStream(&self->stabChain->group->generatorSet, &compressInfo);
 	permutationWordStream->queueMax = 100000;
@@ -363,8 +432,9 @@ static PyObject* PyStabChainObject_order(PyStabChainObject* self, PyObject* args
 		return nullptr;
 	}
 
-	unsigned long long order = self->stabChain->group->Order();
-	PyObject* order_obj = PyLong_FromLongLong((signed)order);
+	// The order can be too big for any fixed-size integer, so it's handed over in decimal.
+	BigUint order = self->stabChain->group->Order();
+	PyObject* order_obj = PyLong_FromString(order.ToString().c_str(), nullptr, 10);
 	return order_obj;
 }
 
@@ -384,6 +454,8 @@ static PyObject* PyStabChainObject_walk(PyStabChainObject* self, PyObject* args)
 		return nullptr;
 	}
 
+	self->stabChain->MaterializeTransversals();
+
 	PermutationProductStream productStream;
 	productStream.Configure(self->stabChain);
 
@@ -442,7 +514,7 @@ static PyObject* PyStabChainObject_factor(PyStabChainObject* self, PyObject* arg
 	}
 
 	Permutation* invPermutation = new Permutation();
-	invPermutation->word = std::make_unique<ElementList>();
+	invPermutation->word = std::make_unique<ElementArray>();
 
 	bool succeeded = false;
 	do
@@ -3,8 +3,15 @@
 #include <iostream>
 #include <fstream>
 #include <time.h>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <climits>
 #include "StabilizerChain.h"
 #include "PermutationStream.h"
+#include "FixedPermutation.h"
+#include "PointMapKernels.h"
+#include "WordEvaluator.h"
 
 enum Puzzle
 {
@@ -27,6 +34,14 @@ enum Puzzle
 };
 
 const char* MakeGenerators( Puzzle puzzle, PermutationSet& generatorSet, UintArray& baseArray );
+bool RunChecks( void );
+bool CheckBinaryDecoding( void );
+bool CheckPartialBase( void );
+bool CheckKernels( void );
+bool CheckPowerWords( void );
+bool CheckClearedSetNodes( void );
+bool CheckJsonRoundTrips( void );
+bool RunBenchmarks( void );
 
 bool StatsCallback(const StabilizerChain::Stats* stats, bool statsMayHaveChanged, double elapsedTimeSec, void* callback_data)
 {
@@ -37,6 +52,12 @@ bool StatsCallback(const StabilizerChain::Stats* stats, bool statsMayHaveChanged
 
 int main( int argc, char** argv )
 {
+	if( argc > 1 && std::string( argv[1] ) == "--check" )
+		return RunChecks() ? 0 : 1;
+
+	if( argc > 1 && std::string( argv[1] ) == "--bench" )
+		return RunBenchmarks() ? 0 : 1;
+
 	clock_t t = clock();
 
 	StabilizerChain* stabChain = new StabilizerChain();
@@ -58,11 +79,11 @@ int main( int argc, char** argv )
 	double elapsed_time = double(t) / double( CLOCKS_PER_SEC );
 	std::cout << "Time taken: " << elapsed_time << " sec\n";
 
-	unsigned long long order = stabChain->GetSubGroupAtDepth(0)->Order();
+	BigUint order = stabChain->GetSubGroupAtDepth(0)->Order();
 
 	if( success )
 	{
-		unsigned long long order = stabChain->group->Order();
+		BigUint order = stabChain->group->Order();
 
 		stabChain->Print( std::cout );
 
@@ -77,7 +98,7 @@ int main( int argc, char** argv )
 
 		const NaturalNumberSet& stabilizerSet = stabChain->group->GetSubgroupStabilizerPointSet();
 
-		PermutationOrbitStream* permutationOrbitStream = new PermutationOrbitStream( &stabChain->group->generatorSet, *stabilizerSet.set.begin(), &compressInfo );
+		PermutationOrbitStream* permutationOrbitStream = new PermutationOrbitStream( &stabChain->group->generatorSet, stabilizerSet.Min(), &compressInfo );
 
 		PermutationWordStream* permutationWordStream = new PermutationWordStream( &stabChain->group->generatorSet, &compressInfo );
 		permutationWordStream->queueMax = 100000;
@@ -91,6 +112,10 @@ int main( int argc, char** argv )
 
 		if( stabChain->OptimizeNames( permutationMultiStream, compressInfo, StatsCallback) )
 		{
+			uint badWordCount = 0;
+			if( !stabChain->VerifyWords( compressInfo, &badWordCount ) )
+				std::cout << badWordCount << " words don't give their permutations!" << std::endl;
+
 			std::string jsonString;
 			stabChain->SaveToJsonString( jsonString );
 		
@@ -108,6 +133,666 @@ int main( int argc, char** argv )
 	return 0;
 }
 
+bool RunChecks( void )
+{
+	bool success = true;
+
+	if( !CheckBinaryDecoding() )
+		success = false;
+
+	if( !CheckJsonRoundTrips() )
+		success = false;
+
+	if( !CheckPartialBase() )
+		success = false;
+
+	if( !CheckKernels() )
+		success = false;
+
+	if( !CheckPowerWords() )
+		success = false;
+
+	if( !CheckClearedSetNodes() )
+		success = false;
+
+	std::cout << ( success ? "All checks passed." : "Some checks failed!" ) << std::endl;
+	return success;
+}
+
+// This stops naming once the streams have given out this many permutations, whether or not
+// everything has been named by then.
+static bool BenchmarkCallback( const StabilizerChain::Stats*, bool, double, void* callback_data )
+{
+	uint* permutationCount = ( uint* )callback_data;
+	return ++( *permutationCount ) >= 200000;
+}
+
+static void PrintBenchmarkCounts( const char* stage, clock_t startTime )
+{
+	std::cout << "  " << stage << ": " << Permutation::copyCount.load() << " copies, " << Permutation::moveCount.load() << " moves, ";
+	std::cout << double( clock() - startTime ) / double( CLOCKS_PER_SEC ) << " sec\n";
+
+	Permutation::copyCount = 0;
+	Permutation::moveCount = 0;
+}
+
+// This counts the permutations copied and moved while generating a chain for each puzzle, and
+// then while naming its transversals the way the main program does.
+bool RunBenchmarks( void )
+{
+	struct Benchmark
+	{
+		const char* name;
+		Puzzle puzzle;
+		bool optimizeNames;
+	};
+
+	const Benchmark benchmarkArray[] =
+	{
+		{ "Rubiks2x2x2", Rubiks2x2x2, true },
+		{ "SymGrpMadPuzzle4", SymGrpMadPuzzle4, true },
+		{ "SymGroup", SymGroup, true },
+		{ "Rubiks3x3x3", Rubiks3x3x3, false }
+	};
+
+	bool success = true;
+
+	for( uint i = 0; i < sizeof( benchmarkArray ) / sizeof( Benchmark ); i++ )
+	{
+		const Benchmark& benchmark = benchmarkArray[i];
+		std::cout << benchmark.name << ":\n";
+
+		PermutationSet generatorSet;
+		UintArray baseArray;
+		MakeGenerators( benchmark.puzzle, generatorSet, baseArray );
+
+		Permutation::copyCount = 0;
+		Permutation::moveCount = 0;
+		clock_t startTime = clock();
+
+		StabilizerChain stabChain;
+		if( !stabChain.Generate( generatorSet, baseArray ) )
+		{
+			std::cout << "  Generate failed!\n";
+			success = false;
+			continue;
+		}
+
+		PrintBenchmarkCounts( "Generate", startTime );
+
+		if( !benchmark.optimizeNames )
+			continue;
+
+		startTime = clock();
+
+		stabChain.group->NameGenerators();
+
+		CompressInfo compressInfo;
+		stabChain.group->MakeCompressInfo( compressInfo );
+
+		const NaturalNumberSet& stabilizerSet = stabChain.group->GetSubgroupStabilizerPointSet();
+
+		PermutationMultiStream permutationMultiStream;
+		permutationMultiStream.permutationStreamArray.push_back( new PermutationOrbitStream( &stabChain.group->generatorSet, stabilizerSet.Min(), &compressInfo ) );
+
+		PermutationWordStream* permutationWordStream = new PermutationWordStream( &stabChain.group->generatorSet, &compressInfo );
+		permutationWordStream->queueMax = 100000;
+		permutationMultiStream.permutationStreamArray.push_back( permutationWordStream );
+
+		permutationMultiStream.permutationStreamArray.push_back( new PermutationStabChainStream( &stabChain, &compressInfo ) );
+
+		uint permutationCount = 0;
+		stabChain.OptimizeNames( permutationMultiStream, compressInfo, BenchmarkCallback, &permutationCount );
+
+		PrintBenchmarkCounts( "OptimizeNames", startTime );
+	}
+
+	return success;
+}
+
+// Whatever the decoder accepts has to be a permutation that survives being written and read
+// back again, and anything else has to be rejected without crashing, hanging or allocating
+// for a degree the bytes don't back up.
+static bool CheckDecodedPermutation( const std::string& binaryString )
+{
+	Permutation permutation;
+	if( !permutation.LoadFromBinaryString( binaryString ) )
+		return true;
+
+	if( !permutation.IsValid() )
+		return false;
+
+	std::string roundTripString;
+	Permutation roundTripPermutation;
+	if( !permutation.SaveToBinaryString( roundTripString ) || !roundTripPermutation.LoadFromBinaryString( roundTripString ) )
+		return false;
+
+	return roundTripPermutation.IsEqualTo( permutation );
+}
+
+bool CheckBinaryDecoding( void )
+{
+	uint failureCount = 0;
+
+	// A cycle-form permutation with no cycles, claiming degrees of 2^29 + 1 and 2^31 + 1.
+	const char* regressionArray[] =
+	{
+		"\x02\x81\x80\x80\x80\x02\x00",
+		"\x02\x81\x80\x80\x80\x08\x00"
+	};
+
+	for( uint i = 0; i < sizeof( regressionArray ) / sizeof( regressionArray[0] ); i++ )
+	{
+		Permutation permutation;
+		if( permutation.LoadFromBinaryString( std::string( regressionArray[i], 7 ) ) )
+			failureCount++;
+	}
+
+	for( uint seed = 1; seed <= 3; seed++ )
+	{
+		std::mt19937 random( seed );
+
+		for( uint i = 0; i < 200000; i++ )
+		{
+			std::string binaryString( 1 + random() % 24, '\0' );
+			for( uint j = 0; j < binaryString.size(); j++ )
+				binaryString[j] = char( random() );
+
+			if( !CheckDecodedPermutation( binaryString ) )
+				failureCount++;
+		}
+
+		// Corrupting a byte of a real encoding gets much further into the decoder than random bytes do.
+		for( uint i = 0; i < 20000; i++ )
+		{
+			uint degree = 1 + random() % 300;
+			UintArray pointArray( degree );
+			for( uint j = 0; j < degree; j++ )
+				pointArray[j] = j;
+			std::shuffle( pointArray.begin(), pointArray.end(), random );
+
+			// Only a few points are moved in some, so that they're written as cycles.
+			Permutation permutation;
+			uint movedCount = ( random() % 2 ) ? degree : random() % degree;
+			for( uint j = 0; j < movedCount; j++ )
+				permutation.Define( pointArray[j], pointArray[ ( j + 1 ) % movedCount ] );
+
+			std::string binaryString;
+			permutation.SaveToBinaryString( binaryString );
+
+			Permutation decodedPermutation;
+			if( !decodedPermutation.LoadFromBinaryString( binaryString ) || !decodedPermutation.IsEqualTo( permutation ) )
+				failureCount++;
+
+			binaryString[ random() % binaryString.size() ] ^= char( 1 + random() % 255 );
+			if( !CheckDecodedPermutation( binaryString ) )
+				failureCount++;
+		}
+	}
+
+	std::cout << "Binary decoding: " << failureCount << " failures.\n";
+	return failureCount == 0;
+}
+
+// The binary form has to say no more and no less than the JSON form.  Whatever is read from
+// the bytes has to be written out as the same JSON, and whatever is read from the JSON has to
+// be written out as the same bytes.
+static bool CheckJsonMatchesBinary( const Permutation& permutation )
+{
+	std::string jsonString, binaryString;
+	if( !permutation.SaveToJsonString( jsonString ) || !permutation.SaveToBinaryString( binaryString ) )
+		return false;
+
+	Permutation binaryPermutation, jsonPermutation;
+	if( !binaryPermutation.LoadFromBinaryString( binaryString ) || !jsonPermutation.LoadFromJsonString( jsonString ) )
+		return false;
+
+	std::string binaryJsonString, jsonBinaryString;
+	if( !binaryPermutation.SaveToJsonString( binaryJsonString ) || !jsonPermutation.SaveToBinaryString( jsonBinaryString ) )
+		return false;
+
+	return binaryJsonString == jsonString && jsonBinaryString == binaryString;
+}
+
+static bool CheckJsonMatchesBinary( const StabilizerChain& stabChain )
+{
+	std::string jsonString, binaryString;
+	if( !stabChain.SaveToJsonString( jsonString ) || !stabChain.SaveToBinaryString( binaryString ) )
+		return false;
+
+	StabilizerChain binaryStabChain, jsonStabChain;
+	if( !binaryStabChain.LoadFromBinaryString( binaryString ) || !jsonStabChain.LoadFromJsonString( jsonString ) )
+		return false;
+
+	std::string binaryJsonString, jsonBinaryString;
+	if( !binaryStabChain.SaveToJsonString( binaryJsonString ) || !jsonStabChain.SaveToBinaryString( jsonBinaryString ) )
+		return false;
+
+	return binaryJsonString == jsonString && jsonBinaryString == binaryString;
+}
+
+// Maps are taken 1, 2 and 4 bytes wide, both dense and sparse enough to be written as cycles,
+// with and without words, and then whole chains with named generators.
+bool CheckJsonRoundTrips( void )
+{
+	uint failureCount = 0;
+
+	std::mt19937 random( 1 );
+
+	const char* nameArray[] = { "a", "b", "c", "d", "e" };
+	const uint degreeArray[] = { 1, 2, 16, 200, 256, 257, 3000, 65536, 65537, 70000 };
+
+	for( uint i = 0; i < sizeof( degreeArray ) / sizeof( uint ); i++ )
+	{
+		uint degree = degreeArray[i];
+
+		for( uint trial = 0; trial < 8; trial++ )
+		{
+			UintArray pointArray( degree );
+			for( uint j = 0; j < degree; j++ )
+				pointArray[j] = j;
+			std::shuffle( pointArray.begin(), pointArray.end(), random );
+
+			Permutation permutation;
+			uint movedCount = ( trial % 2 == 0 ) ? degree : std::min( degree, 1 + uint( random() % 8 ) );
+			for( uint j = 0; j < movedCount; j++ )
+				permutation.Define( pointArray[j], pointArray[ ( j + 1 ) % movedCount ] );
+
+			if( !CheckJsonMatchesBinary( permutation ) )
+				failureCount++;
+
+			// The empty word is a word too, as far as both forms are concerned.
+			permutation.word = std::make_unique<ElementArray>();
+			for( uint j = random() % 12; j > 0; j-- )
+			{
+				Element element;
+				element.id = GeneratorAlphabet::Intern( nameArray[ random() % 5 ] );
+				element.exponent = ( random() % 2 ) ? 1 + int( random() % 4 ) : int( random() );
+				if( element.exponent == 0 )
+					element.exponent = -1;
+				permutation.word->push_back( element );
+			}
+
+			if( !CheckJsonMatchesBinary( permutation ) )
+				failureCount++;
+		}
+	}
+
+	Puzzle puzzleArray[] = { Rubiks2x2x2, Rubiks3x3x3, SymGroup };
+
+	for( uint i = 0; i < sizeof( puzzleArray ) / sizeof( Puzzle ); i++ )
+	{
+		PermutationSet generatorSet;
+		UintArray baseArray;
+		MakeGenerators( puzzleArray[i], generatorSet, baseArray );
+
+		StabilizerChain stabChain;
+		if( !stabChain.Generate( generatorSet, baseArray ) )
+		{
+			failureCount++;
+			continue;
+		}
+
+		stabChain.group->NameGenerators();
+
+		if( !CheckJsonMatchesBinary( stabChain ) )
+			failureCount++;
+	}
+
+	std::cout << "JSON round trips: " << failureCount << " failures.\n";
+	return failureCount == 0;
+}
+
+// The symmetric group on nine points needs eight base points, but only the first is given.
+// Whether the chain is finished by a verified random run, by a random run that has to be
+// completed to reach the known order, or deterministically, with one thread or several, the
+// rest of the base has to be found along the way.
+bool CheckPartialBase( void )
+{
+	uint failureCount = 0;
+
+	Permutation transposition;
+	transposition.DefineCycle( 0, 1 );
+
+	uint cycleArray[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+	Permutation cycle;
+	cycle.DefineCycleArray( cycleArray, 9 );
+
+	PermutationSet generatorSet;
+	generatorSet.insert( transposition );
+	generatorSet.insert( cycle );
+
+	UintArray baseArray;
+	baseArray.push_back(0);
+
+	for( uint i = 0; i < 4; i++ )
+	{
+		StabilizerChain stabChain;
+		stabChain.randomSiftLimit = ( i < 2 ) ? 1 : 0;
+		stabChain.verifyRandomChain = ( i == 0 );
+		stabChain.knownOrder = ( i == 1 ) ? BigUint( 362880 ) : BigUint();
+		stabChain.threadCount = ( i == 3 ) ? 4 : 1;
+
+		if( !stabChain.Generate( generatorSet, baseArray ) || stabChain.group->Order().ToString() != "362880" )
+			failureCount++;
+	}
+
+	std::cout << "Partial base: " << failureCount << " failures.\n";
+	return failureCount == 0;
+}
+
+// A random permutation of the given degree.  Some move only some of their points, so that
+// maps of different sizes get combined.
+static void MakeRandomPermutation( Permutation& permutation, uint degree, std::mt19937& random )
+{
+	UintArray pointArray( degree );
+	for( uint i = 0; i < degree; i++ )
+		pointArray[i] = i;
+
+	uint movedCount = ( random() % 2 ) ? degree : degree / 2 + random() % ( degree / 2 + 1 );
+	std::shuffle( pointArray.begin(), pointArray.begin() + movedCount, random );
+
+	permutation.DefineIdentity();
+	for( uint i = 0; i < degree; i++ )
+		permutation.Define( i, pointArray[i] );
+}
+
+// This copies a permutation one point at a time, so that the copy hasn't been near a kernel.
+static void CopyByPoints( const Permutation& permutation, Permutation& copy, uint degree )
+{
+	copy.DefineIdentity();
+	for( uint i = 0; i < degree; i++ )
+		copy.Define( i, permutation.Evaluate(i) );
+}
+
+static bool HaveSamePoints( const Permutation& permutationA, const Permutation& permutationB, uint degree )
+{
+	for( uint i = 0; i < degree; i++ )
+		if( permutationA.Evaluate(i) != permutationB.Evaluate(i) )
+			return false;
+
+	return true;
+}
+
+// These are the results of every kernel on a pair of permutations, some with the result
+// being one of the operands, all worked out with whichever instruction set is in use.
+struct KernelResults
+{
+	enum
+	{
+		Product,
+		ReverseProduct,
+		Square,
+		AliasedProduct,
+		Quotient,
+		AliasedQuotient,
+		Conjugate,
+		AliasedConjugate,
+		Inverse,
+		AliasedInverse,
+		CopyA,
+		CopyB,
+		PermutationCount
+	};
+
+	void Calculate( const Permutation& permutationA, const Permutation& permutationB, uint degree )
+	{
+		permutationArray[ Product ].Multiply( permutationA, permutationB );
+		permutationArray[ ReverseProduct ].Multiply( permutationB, permutationA );
+
+		permutationArray[ Square ].SetCopy( permutationA, false );
+		permutationArray[ Square ].Multiply( permutationArray[ Square ], permutationArray[ Square ] );
+
+		permutationArray[ AliasedProduct ].SetCopy( permutationB, false );
+		permutationArray[ AliasedProduct ].Multiply( permutationA, permutationArray[ AliasedProduct ] );
+
+		quotientResult = permutationArray[ Quotient ].MultiplyInverse( permutationA, permutationB );
+
+		permutationArray[ AliasedQuotient ].SetCopy( permutationA, false );
+		aliasedQuotientResult = permutationArray[ AliasedQuotient ].MultiplyInverse( permutationArray[ AliasedQuotient ], permutationB );
+
+		permutationArray[ Conjugate ].Conjugate( permutationA, permutationB );
+
+		permutationArray[ AliasedConjugate ].SetCopy( permutationB, false );
+		permutationArray[ AliasedConjugate ].Conjugate( permutationA, permutationArray[ AliasedConjugate ] );
+
+		inverseResult = permutationA.GetInverse( permutationArray[ Inverse ] );
+
+		permutationArray[ AliasedInverse ].SetCopy( permutationB, false );
+		aliasedInverseResult = permutationArray[ AliasedInverse ].SetInverse( permutationArray[ AliasedInverse ] );
+
+		CopyByPoints( permutationA, permutationArray[ CopyA ], degree );
+		CopyByPoints( permutationB, permutationArray[ CopyB ], degree );
+
+		for( uint i = 0; i < PermutationCount; i++ )
+			hashArray[i] = permutationArray[i].CalcHash();
+
+		// The last differs from the first only in its last two points.
+		Permutation nearCopyA;
+		CopyByPoints( permutationA, nearCopyA, degree );
+		if( degree >= 2 )
+		{
+			nearCopyA.Define( degree - 1, permutationA.Evaluate( degree - 2 ) );
+			nearCopyA.Define( degree - 2, permutationA.Evaluate( degree - 1 ) );
+		}
+
+		equalArray[0] = permutationA.IsEqualTo( permutationB );
+		equalArray[1] = permutationA.IsEqualTo( permutationArray[ CopyA ] );
+		equalArray[2] = permutationArray[ Square ].IsEqualTo( permutationArray[ AliasedProduct ] );
+		equalArray[3] = permutationA.IsEqualTo( nearCopyA );
+	}
+
+	bool Matches( const KernelResults& results, uint degree ) const
+	{
+		for( uint i = 0; i < PermutationCount; i++ )
+			if( !HaveSamePoints( permutationArray[i], results.permutationArray[i], degree ) || hashArray[i] != results.hashArray[i] )
+				return false;
+
+		for( uint i = 0; i < 4; i++ )
+			if( equalArray[i] != results.equalArray[i] )
+				return false;
+
+		return quotientResult == results.quotientResult &&
+			aliasedQuotientResult == results.aliasedQuotientResult &&
+			inverseResult == results.inverseResult &&
+			aliasedInverseResult == results.aliasedInverseResult;
+	}
+
+	Permutation permutationArray[ PermutationCount ];
+	std::size_t hashArray[ PermutationCount ];
+	bool equalArray[4];
+	bool quotientResult;
+	bool aliasedQuotientResult;
+	bool inverseResult;
+	bool aliasedInverseResult;
+};
+
+// Every instruction set the processor supports has to give exactly what the scalar kernels
+// give, on maps 1, 2 and 4 bytes wide, including maps of different sizes and widths, and
+// when the result is also one of the operands.
+bool CheckKernels( void )
+{
+	uint failureCount = 0;
+
+	PointMapKernels::InstructionSet supportedInstructionSet = PointMapKernels::GetSupportedInstructionSet();
+	std::mt19937 random( 1 );
+
+	// The widest degree in each range takes maps of that width.
+	const uint degreeRangeArray[][2] = { { 1, 256 }, { 257, 3000 }, { 65537, 66000 } };
+	const uint trialCountArray[] = { 3000, 300, 8 };
+
+	for( uint i = 0; i < 3; i++ )
+	{
+		for( uint trial = 0; trial < trialCountArray[i]; trial++ )
+		{
+			uint minDegree = degreeRangeArray[i][0];
+			uint degreeA = minDegree + random() % ( degreeRangeArray[i][1] - minDegree + 1 );
+			uint degreeB = ( trial % 4 == 0 ) ? 1 + random() % degreeA : degreeA;
+
+			Permutation permutationA, permutationB;
+			MakeRandomPermutation( permutationA, degreeA, random );
+			MakeRandomPermutation( permutationB, degreeB, random );
+
+			PointMapKernels::SetInstructionSet( PointMapKernels::ScalarInstructions );
+			KernelResults scalarResults;
+			scalarResults.Calculate( permutationA, permutationB, degreeA );
+
+			for( int instructionSet = PointMapKernels::SSSE3Instructions; instructionSet <= supportedInstructionSet; instructionSet++ )
+			{
+				PointMapKernels::SetInstructionSet( ( PointMapKernels::InstructionSet )instructionSet );
+				KernelResults results;
+				results.Calculate( permutationA, permutationB, degreeA );
+				if( !results.Matches( scalarResults, degreeA ) )
+				{
+					std::cout << "Instruction set " << instructionSet << " disagrees at degrees " << degreeA << " and " << degreeB << ".\n";
+					failureCount++;
+				}
+			}
+		}
+	}
+
+	PointMapKernels::SetInstructionSet( supportedInstructionSet );
+
+	std::cout << "Kernels: " << failureCount << " failures, up to instruction set " << supportedInstructionSet << ".\n";
+	return failureCount == 0;
+}
+
+// Powers of worded permutations, by exponents up to the largest there are, have to have words
+// that still give them, and that stay short until they're flattened.  Exponents are reduced by
+// the order of the permutation when it's known, and a single element's exponent is multiplied
+// only when the product fits.
+bool CheckPowerWords( void )
+{
+	uint failureCount = 0;
+
+	uint cycleArray[] = { 0, 1, 2, 3, 4, 5, 6 };
+	Permutation cycle, transposition;
+	cycle.DefineCycleArray( cycleArray, 7 );
+	transposition.DefineCycle( 0, 1 );
+
+	CompressInfo compressInfo;
+	compressInfo.permutationMap[ "c" ] = cycle;
+	compressInfo.permutationMap[ "t" ] = transposition;
+
+	WordEvaluator wordEvaluator;
+	wordEvaluator.Build( compressInfo );
+
+	Element cycleElement, transpositionElement;
+	cycleElement.id = GeneratorAlphabet::Intern( "c" );
+	cycleElement.exponent = 1;
+	transpositionElement.id = GeneratorAlphabet::Intern( "t" );
+	transpositionElement.exponent = 1;
+
+	// The product of the cycle and the transposition has order 6, so its powers have words of at
+	// most six letters.  The cycles of the last are of every prime length up to 47, which gives
+	// it an order of more than 2^64.
+	Permutation product, programProduct, largeOrderProduct;
+	product.Multiply( cycle, transposition );
+	product.word = std::make_unique<ElementArray>( ElementArray{ cycleElement, transpositionElement } );
+	programProduct.SetCopy( product );
+	programProduct.MakeWordProgram();
+
+	uint primeArray[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47 };
+	uint first = 0;
+	for( uint i = 0; i < sizeof( primeArray ) / sizeof( uint ); i++ )
+	{
+		UintArray pointArray;
+		for( uint j = 0; j < primeArray[i]; j++ )
+			pointArray.push_back( first + j );
+
+		largeOrderProduct.DefineCycleArray( pointArray.data(), primeArray[i] );
+		first += primeArray[i];
+	}
+	largeOrderProduct.word = std::make_unique<ElementArray>( ElementArray{ cycleElement, transpositionElement } );
+
+	std::mt19937 random( 1 );
+
+	for( uint i = 0; i < 2000; i++ )
+	{
+		int exponentArray[] = { INT_MIN, INT_MAX, 1 << 27, -( 1 << 27 ) };
+		int exponent = ( i < 4 ) ? exponentArray[i] : int( random() );
+
+		Permutation power;
+		power.Power( product, exponent );
+		if( !wordEvaluator.Verify( power ) || power.WordLength() > 6 )
+			failureCount++;
+
+		power.Power( programProduct, exponent );
+		if( !wordEvaluator.Verify( power ) || power.WordLength() > 6 )
+			failureCount++;
+
+		// The cycle's exponent is a multiple of its order plus a little, so most products overflow an int.
+		Permutation cyclePower;
+		cyclePower.SetCopy( cycle, false );
+		cyclePower.word = std::make_unique<ElementArray>( 1, cycleElement );
+		( *cyclePower.word )[0].exponent = 7 * int( random() % 100000 ) + 1;
+
+		power.Power( cyclePower, exponent );
+		if( !wordEvaluator.Verify( power ) )
+			failureCount++;
+
+		// Nothing is reduced here, so the word is only checked for its length, without flattening it.
+		power.Power( largeOrderProduct, exponent );
+		if( power.WordLength() != uint( std::min( 2 * std::abs( int64_t( exponent ) ), int64_t( 0xFFFFFFFF ) ) ) )
+			failureCount++;
+	}
+
+	std::cout << "Power words: " << failureCount << " failures.\n";
+	return failureCount == 0;
+}
+
+// A permutation extracted from a set has to survive the set being cleared, keeping its slot
+// to itself until the node puts it back or lets it go, as a stream's queue does when it's reset.
+bool CheckClearedSetNodes( void )
+{
+	uint failureCount = 0;
+
+	for( uint i = 0; i < 2; i++ )
+	{
+		PermutationSet permutationSet;
+		for( uint j = 1; j < 10; j++ )
+		{
+			Permutation permutation;
+			permutation.DefineCycle( 0, j );
+			permutationSet.insert( permutation );
+		}
+
+		PermutationSet::node_type node = permutationSet.extract( permutationSet.find( permutationSet.Get(4) ) );
+		permutationSet.clear();
+
+		// Every handle given out now has to be other than the node's.
+		for( uint j = 1; j < 20; j++ )
+		{
+			Permutation permutation;
+			permutation.DefineCycle( 1, j + 1 );
+			if( permutationSet.insert( permutation ).first.handle == node.handle )
+				failureCount++;
+		}
+
+		Permutation transposition;
+		transposition.DefineCycle( 0, 5 );
+		if( !node.value().IsEqualTo( transposition ) )
+			failureCount++;
+
+		// The node either goes back in or is destroyed along with its permutation.
+		if( i == 0 )
+		{
+			permutationSet.insert( std::move( node ) );
+			if( permutationSet.size() != 20 || permutationSet.find( transposition ) == permutationSet.end() )
+				failureCount++;
+		}
+		else
+		{
+			node = PermutationSet::node_type();
+			if( permutationSet.size() != 19 || permutationSet.insert( transposition ).first.handle >= 20 )
+				failureCount++;
+		}
+	}
+
+	std::cout << "Cleared set nodes: " << failureCount << " failures.\n";
+	return failureCount == 0;
+}
+
 const char* MakeGenerators( Puzzle puzzle, PermutationSet& generatorSet, UintArray& baseArray )
 {
 	const char* fileName = nullptr;
@@ -1630,43 +2315,17 @@ const char* MakeGenerators( Puzzle puzzle, PermutationSet& generatorSet, UintArr
 		}
 		case Rubiks2x2x2:
 		{
-			Permutation permutation;
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 0, 1, 2, 3 );
-			permutation.DefineCycle( 13, 18, 7, 20 );
-			permutation.DefineCycle( 14, 19, 4, 21 );
-			generatorSet.insert( permutation );
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 4, 5, 6, 7 );
-			permutation.DefineCycle( 2, 18, 8, 22 );
-			permutation.DefineCycle( 1, 17, 11, 21 );
-			generatorSet.insert( permutation );
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 8, 9, 10, 11 );
-			permutation.DefineCycle( 5, 16, 15, 22 );
-			permutation.DefineCycle( 6, 17, 12, 23 );
-			generatorSet.insert( permutation );
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 12, 13, 14, 15 );
-			permutation.DefineCycle( 0, 20, 10, 16 );
-			permutation.DefineCycle( 3, 23, 9, 19 );
-			generatorSet.insert( permutation );
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 16, 17, 18, 19 );
-			permutation.DefineCycle( 0, 12, 8, 4 );
-			permutation.DefineCycle( 1, 13, 9, 5 );
-			generatorSet.insert( permutation );
-
-			permutation.DefineIdentity();
-			permutation.DefineCycle( 20, 21, 22, 23 );
-			permutation.DefineCycle( 2, 6, 10, 14 );
-			permutation.DefineCycle( 3, 7, 11, 15 );
-			generatorSet.insert( permutation );
+			static constexpr FixedPermutation< 24 > generatorTable[] =
+			{
+				{ { 0, 1, 2, 3 }, { 13, 18, 7, 20 }, { 14, 19, 4, 21 } },
+				{ { 4, 5, 6, 7 }, { 2, 18, 8, 22 }, { 1, 17, 11, 21 } },
+				{ { 8, 9, 10, 11 }, { 5, 16, 15, 22 }, { 6, 17, 12, 23 } },
+				{ { 12, 13, 14, 15 }, { 0, 20, 10, 16 }, { 3, 23, 9, 19 } },
+				{ { 16, 17, 18, 19 }, { 0, 12, 8, 4 }, { 1, 13, 9, 5 } },
+				{ { 20, 21, 22, 23 }, { 2, 6, 10, 14 }, { 3, 7, 11, 15 } }
+			};
+
+			InsertFixedPermutations( generatorTable, generatorSet );
 
 			for( uint i = 0; i < 24; i++ )
 				baseArray.push_back(i);